@@ -1,6 +1,7 @@
 #pragma once
 #include <thread>
 #include <future>
+#include <vector>
 
 template<typename T>
 auto __await_async(T lambda)->decltype(lambda())
@@ -13,6 +14,41 @@ auto __await_async(T lambda)->decltype(lambda())
 	return func.get();
 }
 
+//Splits [0, count) into one range per hardware thread and runs body(begin, end) on each,
+//the calling thread takes the first range. Ranges smaller than minChunk are not split further.
+template<typename T>
+void __parallel_for(size_t count, size_t minChunk, T body)
+{
+	size_t threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	if (minChunk == 0)
+		minChunk = 1;
+
+	size_t chunks = (count + minChunk - 1) / minChunk;
+	if (chunks > threads)
+		chunks = threads;
+	if (chunks <= 1)
+	{
+		if (count)
+			body((size_t)0, count);
+		return;
+	}
+
+	size_t step = (count + chunks - 1) / chunks;
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(chunks - 1);
+	for (size_t begin = step; begin < count; begin += step)
+	{
+		size_t end = begin + step < count ? begin + step : count;
+		tasks.push_back(std::async(std::launch::async, [=]() { body(begin, end); }));
+	}
+
+	body((size_t)0, step);
+	for (std::future<void>& task : tasks)
+		task.get();
+}
+
 #define _async_t(block) std::async(std::launch::deferred, [=](){block});
 
 #define _await_t(block) __await_async([&] {block});
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "BatchKernels.h"
+#include "TransformBatch.h"
+#include "ProfileCounters.h"
+#include "StrictFloat.h"
+#include <cmath>
+
+ESGS_STRICT_FLOAT_BEGIN
+
+static void normalize3Scalar(float* x, float* y, float* z, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        if (mag > epsilon)
+        {
+            float inv = 1.0f / mag;
+            x[i] *= inv;
+            y[i] *= inv;
+            z[i] *= inv;
+        }
+        else
+        {
+            x[i] = 0.0f;
+            y[i] = 0.0f;
+            z[i] = 0.0f;
+        }
+    }
+}
+
+static void dot3Scalar(const float* ax, const float* ay, const float* az,
+    const float* bx, const float* by, const float* bz, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+}
+
+static void transformPointsScalar(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t count)
+{
+    const float (*m)[4] = matrix.m_mat;
+    for (size_t i = 0; i < count; i++)
+    {
+        float px = x[i], py = y[i], pz = z[i];
+        outX[i] = px * m[0][0] + py * m[1][0] + pz * m[2][0] + m[3][0];
+        outY[i] = px * m[0][1] + py * m[1][1] + pz * m[2][1] + m[3][1];
+        outZ[i] = px * m[0][2] + py * m[1][2] + pz * m[2][2] + m[3][2];
+    }
+}
+
+static void multiplyMatricesScalar(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        Matrix4x4 result = a[n];
+        result *= b[n];
+        out[n].setMatrix(result);
+    }
+}
+
+static void normalizeQuaternionsScalar(float* x, float* y, float* z, float* w, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        if (mag < epsilon)
+        {
+            x[i] = 0.0f;
+            y[i] = 0.0f;
+            z[i] = 0.0f;
+            w[i] = 1.0f;
+            continue;
+        }
+
+        float inv = 1.0f / mag;
+        x[i] *= inv;
+        y[i] *= inv;
+        z[i] *= inv;
+        w[i] *= inv;
+    }
+}
+
+static size_t decomposeTransformsScalar(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+    Quaternion* rotations, Vector3D* scales, uint8_t* shear)
+{
+    size_t sheared = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        bool s = TransformBatch::decompose(matrices[i], translations[i], rotations[i], scales[i]);
+        if (shear)
+            shear[i] = s ? 1 : 0;
+        sheared += s ? 1 : 0;
+    }
+    return sheared;
+}
+
+static void composeTransformsScalar(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+    size_t count, Matrix4x4* matrices)
+{
+    for (size_t i = 0; i < count; i++)
+        TransformBatch::compose(translations[i], rotations[i], scales[i], matrices[i]);
+}
+
+static void cullSpheresScalar(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+    const float* radius, uint8_t* visible, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t inside = 1;
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            float d = planes[p].x * x[i] + planes[p].y * y[i] + planes[p].z * z[i] + planes[p].w;
+            if (d < -radius[i])
+            {
+                inside = 0;
+                break;
+            }
+        }
+        visible[i] = inside;
+    }
+}
+
+static void encodeSnorm16Scalar(const float* in, int16_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float v = in[i];
+        v = v != v ? 0.0f : (v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v));
+        out[i] = (int16_t)lrintf(v * 32767.0f);
+    }
+}
+
+void registerBatchKernelsScalar(BatchKernelTable& table)
+{
+    table.normalize3 = normalize3Scalar;
+    table.dot3 = dot3Scalar;
+    table.transformPoints = transformPointsScalar;
+    table.multiplyMatrices = multiplyMatricesScalar;
+    table.normalizeQuaternions = normalizeQuaternionsScalar;
+    table.decomposeTransforms = decomposeTransformsScalar;
+    table.composeTransforms = composeTransformsScalar;
+    table.cullSpheres = cullSpheresScalar;
+    table.encodeSnorm16 = encodeSnorm16Scalar;
+    table.level = SimdLevel::Scalar;
+}
+
+BatchKernelTable BatchKernels::create(SimdLevel level)
+{
+    SimdLevel supported = CpuFeatures::getSupportedLevel();
+    if ((int)level > (int)supported)
+        level = supported;
+
+    BatchKernelTable table;
+    registerBatchKernelsScalar(table);
+
+#ifdef ESGS_SSE2
+    if ((int)level >= (int)SimdLevel::SSE2)
+        registerBatchKernelsSSE2(table);
+    if ((int)level >= (int)SimdLevel::AVX2)
+        registerBatchKernelsAVX2(table);
+    if ((int)level >= (int)SimdLevel::AVX512)
+        registerBatchKernelsAVX512(table);
+#endif
+
+    return table;
+}
+
+#ifdef ESGS_INSTRUMENTATION
+//get() hands out these wrappers around the dispatched kernels, tables from create()
+//stay unwrapped so level comparisons are not skewed by the counters
+static BatchKernelTable dispatchedKernels;
+
+static void normalize3Profiled(float* x, float* y, float* z, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchVector);
+    ESGS_COUNT(BatchVector, count);
+    dispatchedKernels.normalize3(x, y, z, count);
+}
+
+static void dot3Profiled(const float* ax, const float* ay, const float* az,
+    const float* bx, const float* by, const float* bz, float* out, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchVector);
+    ESGS_COUNT(BatchVector, count);
+    dispatchedKernels.dot3(ax, ay, az, bx, by, bz, out, count);
+}
+
+static void transformPointsProfiled(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchMatrix);
+    ESGS_COUNT(BatchMatrix, count);
+    dispatchedKernels.transformPoints(matrix, x, y, z, outX, outY, outZ, count);
+}
+
+static void multiplyMatricesProfiled(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchMatrix);
+    ESGS_COUNT(BatchMatrix, count);
+    dispatchedKernels.multiplyMatrices(a, b, out, count);
+}
+
+static void normalizeQuaternionsProfiled(float* x, float* y, float* z, float* w, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchQuaternion);
+    ESGS_COUNT(BatchQuaternion, count);
+    dispatchedKernels.normalizeQuaternions(x, y, z, w, count);
+}
+
+static size_t decomposeTransformsProfiled(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+    Quaternion* rotations, Vector3D* scales, uint8_t* shear)
+{
+    ESGS_SCOPED_TIMER(BatchTransform);
+    ESGS_COUNT(BatchTransform, count);
+    return dispatchedKernels.decomposeTransforms(matrices, count, translations, rotations, scales, shear);
+}
+
+static void composeTransformsProfiled(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+    size_t count, Matrix4x4* matrices)
+{
+    ESGS_SCOPED_TIMER(BatchTransform);
+    ESGS_COUNT(BatchTransform, count);
+    dispatchedKernels.composeTransforms(translations, rotations, scales, count, matrices);
+}
+
+static void cullSpheresProfiled(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+    const float* radius, uint8_t* visible, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchCulling);
+    ESGS_COUNT(BatchCulling, count);
+    dispatchedKernels.cullSpheres(planes, planeCount, x, y, z, radius, visible, count);
+}
+
+static void encodeSnorm16Profiled(const float* in, int16_t* out, size_t count)
+{
+    ESGS_SCOPED_TIMER(BatchEncoding);
+    ESGS_COUNT(BatchEncoding, count);
+    dispatchedKernels.encodeSnorm16(in, out, count);
+}
+
+static BatchKernelTable createProfiled()
+{
+    dispatchedKernels = BatchKernels::create(CpuFeatures::getLevel());
+
+    BatchKernelTable table = dispatchedKernels;
+    table.normalize3 = normalize3Profiled;
+    table.dot3 = dot3Profiled;
+    table.transformPoints = transformPointsProfiled;
+    table.multiplyMatrices = multiplyMatricesProfiled;
+    table.normalizeQuaternions = normalizeQuaternionsProfiled;
+    table.decomposeTransforms = decomposeTransformsProfiled;
+    table.composeTransforms = composeTransformsProfiled;
+    table.cullSpheres = cullSpheresProfiled;
+    table.encodeSnorm16 = encodeSnorm16Profiled;
+    return table;
+}
+#endif
+
+const BatchKernelTable& BatchKernels::get()
+{
+#ifdef ESGS_INSTRUMENTATION
+    static const BatchKernelTable table = createProfiled();
+#else
+    static const BatchKernelTable table = create(CpuFeatures::getLevel());
+#endif
+    return table;
+}
+
+ESGS_STRICT_FLOAT_END
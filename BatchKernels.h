@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Quaternion.h"
+#include "Matrix4x4.h"
+#include "CpuFeatures.h"
+#include "Export.h"
+
+//Function table for the kit's batch kernels. Vector data is passed as structure of
+//arrays so that every instruction set works on full registers.
+struct BatchKernelTable
+{
+	//Same zero fallback as Vector3D::normalize
+	void (*normalize3)(float* x, float* y, float* z, size_t count);
+
+	void (*dot3)(const float* ax, const float* ay, const float* az,
+		const float* bx, const float* by, const float* bz, float* out, size_t count);
+
+	//Row-vector points times matrix, w = 1
+	void (*transformPoints)(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+		float* outX, float* outY, float* outZ, size_t count);
+
+	//out[i] = a[i] * b[i], same order as Matrix4x4::operator *=
+	void (*multiplyMatrices)(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count);
+
+	//Same identity fallback as Quaternion::normalizeSafe
+	void (*normalizeQuaternions)(float* x, float* y, float* z, float* w, size_t count);
+
+	//See TransformBatch
+	size_t (*decomposeTransforms)(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+		Quaternion* rotations, Vector3D* scales, uint8_t* shear);
+	void (*composeTransforms)(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+		size_t count, Matrix4x4* matrices);
+
+	//planes are (normal, d) with the normal pointing inside, visible[i] is 1 when the
+	//sphere is not completely behind any plane
+	void (*cullSpheres)(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+		const float* radius, uint8_t* visible, size_t count);
+
+	//Clamps to [-1, 1] and rounds to nearest even, NaN encodes as 0
+	void (*encodeSnorm16)(const float* in, int16_t* out, size_t count);
+
+	SimdLevel level = SimdLevel::Scalar;
+};
+
+class ESGS_EXPORT BatchKernels
+{
+public:
+	//Bound once to CpuFeatures::getLevel()
+	static const BatchKernelTable& get();
+
+	//Table for a specific level, lower levels fill in kernels a level does not provide.
+	//Requesting more than the CPU supports is clamped to CpuFeatures::getSupportedLevel().
+	static BatchKernelTable create(SimdLevel level);
+};
+
+//Registration of the instruction set specific kernels, see BatchKernels*.cpp
+void registerBatchKernelsScalar(BatchKernelTable& table);
+void registerBatchKernelsSSE2(BatchKernelTable& table);
+void registerBatchKernelsAVX2(BatchKernelTable& table);
+void registerBatchKernelsAVX512(BatchKernelTable& table);
@@ -0,0 +1,257 @@
+#include "BatchKernels.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+#include <cmath>
+
+#ifdef ESGS_SSE2
+#include <immintrin.h>
+
+ESGS_STRICT_FLOAT_BEGIN
+
+ESGS_TARGET_AVX2 static void normalize3AVX2(float* x, float* y, float* z, size_t count)
+{
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 eps = _mm256_set1_ps((float)epsilon);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        __m256 mag = _mm256_sqrt_ps(len2);
+        __m256 valid = _mm256_cmp_ps(mag, eps, _CMP_GT_OQ);
+        __m256 inv = _mm256_div_ps(one, mag);
+        _mm256_storeu_ps(x + i, _mm256_and_ps(valid, _mm256_mul_ps(vx, inv)));
+        _mm256_storeu_ps(y + i, _mm256_and_ps(valid, _mm256_mul_ps(vy, inv)));
+        _mm256_storeu_ps(z + i, _mm256_and_ps(valid, _mm256_mul_ps(vz, inv)));
+    }
+
+    for (; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        if (mag > epsilon)
+        {
+            float inv = 1.0f / mag;
+            x[i] *= inv;
+            y[i] *= inv;
+            z[i] *= inv;
+        }
+        else
+        {
+            x[i] = 0.0f;
+            y[i] = 0.0f;
+            z[i] = 0.0f;
+        }
+    }
+}
+
+ESGS_TARGET_AVX2 static void dot3AVX2(const float* ax, const float* ay, const float* az,
+    const float* bx, const float* by, const float* bz, float* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 d = _mm256_mul_ps(_mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i)));
+        d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i)));
+        _mm256_storeu_ps(out + i, d);
+    }
+
+    for (; i < count; i++)
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+}
+
+ESGS_TARGET_AVX2 static void transformPointsAVX2(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t count)
+{
+    const float (*m)[4] = matrix.m_mat;
+    float* out[3] = { outX, outY, outZ };
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        for (int col = 0; col < 3; col++)
+        {
+            __m256 r = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(m[0][col])), _mm256_mul_ps(py, _mm256_set1_ps(m[1][col])));
+            r = _mm256_add_ps(r, _mm256_mul_ps(pz, _mm256_set1_ps(m[2][col])));
+            r = _mm256_add_ps(r, _mm256_set1_ps(m[3][col]));
+            _mm256_storeu_ps(out[col] + i, r);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        float px = x[i], py = y[i], pz = z[i];
+        outX[i] = px * m[0][0] + py * m[1][0] + pz * m[2][0] + m[3][0];
+        outY[i] = px * m[0][1] + py * m[1][1] + pz * m[2][1] + m[3][1];
+        outZ[i] = px * m[0][2] + py * m[1][2] + pz * m[2][2] + m[3][2];
+    }
+}
+
+//Row in both 128-bit halves. Matrix4x4 is only 4-byte aligned, so the row is read
+//with an unaligned load instead of dereferencing it as __m128
+ESGS_TARGET_AVX2 static __m256 broadcastRow(const float* row)
+{
+    __m128 r = _mm_loadu_ps(row);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(r), r, 1);
+}
+
+//Two rows of a per register, each multiplied by the broadcast rows of b
+ESGS_TARGET_AVX2 static void multiplyMatricesAVX2(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        __m256 b0 = broadcastRow(b[n].m_mat[0]);
+        __m256 b1 = broadcastRow(b[n].m_mat[1]);
+        __m256 b2 = broadcastRow(b[n].m_mat[2]);
+        __m256 b3 = broadcastRow(b[n].m_mat[3]);
+
+        __m256 a01 = _mm256_loadu_ps(a[n].m_mat[0]);
+        __m256 a23 = _mm256_loadu_ps(a[n].m_mat[2]);
+
+        __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3));
+
+        __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3));
+
+        _mm256_storeu_ps(out[n].m_mat[0], r01);
+        _mm256_storeu_ps(out[n].m_mat[2], r23);
+    }
+}
+
+ESGS_TARGET_AVX2 static void normalizeQuaternionsAVX2(float* x, float* y, float* z, float* w, size_t count)
+{
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 eps = _mm256_set1_ps((float)epsilon);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 vw = _mm256_loadu_ps(w + i);
+        __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)),
+            _mm256_mul_ps(vz, vz)), _mm256_mul_ps(vw, vw));
+        __m256 mag = _mm256_sqrt_ps(len2);
+        __m256 valid = _mm256_cmp_ps(mag, eps, _CMP_NLT_UQ);
+        __m256 inv = _mm256_and_ps(valid, _mm256_div_ps(one, mag));
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(vx, inv));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(vy, inv));
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(vz, inv));
+        _mm256_storeu_ps(w + i, _mm256_blendv_ps(one, _mm256_mul_ps(vw, inv), valid));
+    }
+
+    for (; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        float inv = mag < epsilon ? 0.0f : 1.0f / mag;
+        x[i] *= inv;
+        y[i] *= inv;
+        z[i] *= inv;
+        w[i] = mag < epsilon ? 1.0f : w[i] * inv;
+    }
+}
+
+ESGS_TARGET_AVX2 static void cullSpheresAVX2(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+    const float* radius, uint8_t* visible, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 nr = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+        __m256 outside = _mm256_setzero_ps();
+
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].x), px), _mm256_mul_ps(_mm256_set1_ps(planes[p].y), py));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), pz));
+            d = _mm256_add_ps(d, _mm256_set1_ps(planes[p].w));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, nr, _CMP_LT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; k++)
+            visible[i + k] = (uint8_t)(((mask >> k) & 1) ^ 1);
+    }
+
+    for (; i < count; i++)
+    {
+        uint8_t inside = 1;
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            float d = planes[p].x * x[i] + planes[p].y * y[i] + planes[p].z * z[i] + planes[p].w;
+            if (d < -radius[i])
+            {
+                inside = 0;
+                break;
+            }
+        }
+        visible[i] = inside;
+    }
+}
+
+ESGS_TARGET_AVX2 static void encodeSnorm16AVX2(const float* in, int16_t* out, size_t count)
+{
+    __m256 lo = _mm256_set1_ps(-1.0f);
+    __m256 hi = _mm256_set1_ps(1.0f);
+    __m256 scale = _mm256_set1_ps(32767.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        //NaN lanes are zeroed first, max/min would turn them into -1
+        __m256 va = _mm256_loadu_ps(in + i);
+        __m256 vb = _mm256_loadu_ps(in + i + 8);
+        va = _mm256_and_ps(va, _mm256_cmp_ps(va, va, _CMP_ORD_Q));
+        vb = _mm256_and_ps(vb, _mm256_cmp_ps(vb, vb, _CMP_ORD_Q));
+        __m256 a = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(va, lo), hi), scale);
+        __m256 b = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(vb, lo), hi), scale);
+        //packs works per 128-bit lane, the permute restores element order
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256((__m256i*)(out + i), packed);
+    }
+
+    for (; i < count; i++)
+    {
+        float v = in[i];
+        v = v != v ? 0.0f : (v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v));
+        out[i] = (int16_t)lrintf(v * 32767.0f);
+    }
+}
+
+void registerBatchKernelsAVX2(BatchKernelTable& table)
+{
+    table.normalize3 = normalize3AVX2;
+    table.dot3 = dot3AVX2;
+    table.transformPoints = transformPointsAVX2;
+    table.multiplyMatrices = multiplyMatricesAVX2;
+    table.normalizeQuaternions = normalizeQuaternionsAVX2;
+    table.cullSpheres = cullSpheresAVX2;
+    table.encodeSnorm16 = encodeSnorm16AVX2;
+    table.level = SimdLevel::AVX2;
+}
+
+ESGS_STRICT_FLOAT_END
+
+#else
+
+void registerBatchKernelsAVX2(BatchKernelTable&)
+{
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "BatchKernels.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+
+#ifdef ESGS_SSE2
+#include <immintrin.h>
+
+ESGS_STRICT_FLOAT_BEGIN
+
+//Tails are handled with masked loads and stores, no scalar remainder loops
+
+ESGS_TARGET_AVX512 static __mmask16 tailMask(size_t remaining)
+{
+    return remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+}
+
+ESGS_TARGET_AVX512 static void normalize3AVX512(float* x, float* y, float* z, size_t count)
+{
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 eps = _mm512_set1_ps((float)epsilon);
+
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        __m512 vx = _mm512_maskz_loadu_ps(k, x + i);
+        __m512 vy = _mm512_maskz_loadu_ps(k, y + i);
+        __m512 vz = _mm512_maskz_loadu_ps(k, z + i);
+        __m512 len2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)), _mm512_mul_ps(vz, vz));
+        __m512 mag = _mm512_sqrt_ps(len2);
+        __mmask16 valid = _mm512_cmp_ps_mask(mag, eps, _CMP_GT_OQ);
+        __m512 inv = _mm512_div_ps(one, mag);
+        _mm512_mask_storeu_ps(x + i, k, _mm512_maskz_mul_ps(valid, vx, inv));
+        _mm512_mask_storeu_ps(y + i, k, _mm512_maskz_mul_ps(valid, vy, inv));
+        _mm512_mask_storeu_ps(z + i, k, _mm512_maskz_mul_ps(valid, vz, inv));
+    }
+}
+
+ESGS_TARGET_AVX512 static void dot3AVX512(const float* ax, const float* ay, const float* az,
+    const float* bx, const float* by, const float* bz, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        __m512 d = _mm512_mul_ps(_mm512_maskz_loadu_ps(k, ax + i), _mm512_maskz_loadu_ps(k, bx + i));
+        d = _mm512_add_ps(d, _mm512_mul_ps(_mm512_maskz_loadu_ps(k, ay + i), _mm512_maskz_loadu_ps(k, by + i)));
+        d = _mm512_add_ps(d, _mm512_mul_ps(_mm512_maskz_loadu_ps(k, az + i), _mm512_maskz_loadu_ps(k, bz + i)));
+        _mm512_mask_storeu_ps(out + i, k, d);
+    }
+}
+
+ESGS_TARGET_AVX512 static void transformPointsAVX512(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t count)
+{
+    const float (*m)[4] = matrix.m_mat;
+    float* out[3] = { outX, outY, outZ };
+
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        __m512 px = _mm512_maskz_loadu_ps(k, x + i);
+        __m512 py = _mm512_maskz_loadu_ps(k, y + i);
+        __m512 pz = _mm512_maskz_loadu_ps(k, z + i);
+        for (int col = 0; col < 3; col++)
+        {
+            __m512 r = _mm512_add_ps(_mm512_mul_ps(px, _mm512_set1_ps(m[0][col])), _mm512_mul_ps(py, _mm512_set1_ps(m[1][col])));
+            r = _mm512_add_ps(r, _mm512_mul_ps(pz, _mm512_set1_ps(m[2][col])));
+            r = _mm512_add_ps(r, _mm512_set1_ps(m[3][col]));
+            _mm512_mask_storeu_ps(out[col] + i, k, r);
+        }
+    }
+}
+
+ESGS_TARGET_AVX512 static void normalizeQuaternionsAVX512(float* x, float* y, float* z, float* w, size_t count)
+{
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 eps = _mm512_set1_ps((float)epsilon);
+
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        __m512 vx = _mm512_maskz_loadu_ps(k, x + i);
+        __m512 vy = _mm512_maskz_loadu_ps(k, y + i);
+        __m512 vz = _mm512_maskz_loadu_ps(k, z + i);
+        __m512 vw = _mm512_maskz_loadu_ps(k, w + i);
+        __m512 len2 = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)),
+            _mm512_mul_ps(vz, vz)), _mm512_mul_ps(vw, vw));
+        __m512 mag = _mm512_sqrt_ps(len2);
+        __mmask16 valid = _mm512_cmp_ps_mask(mag, eps, _CMP_NLT_UQ);
+        __m512 inv = _mm512_maskz_div_ps(valid, one, mag);
+        _mm512_mask_storeu_ps(x + i, k, _mm512_mul_ps(vx, inv));
+        _mm512_mask_storeu_ps(y + i, k, _mm512_mul_ps(vy, inv));
+        _mm512_mask_storeu_ps(z + i, k, _mm512_mul_ps(vz, inv));
+        _mm512_mask_storeu_ps(w + i, k, _mm512_mask_mul_ps(one, valid, vw, inv));
+    }
+}
+
+ESGS_TARGET_AVX512 static void cullSpheresAVX512(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+    const float* radius, uint8_t* visible, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        __m512 px = _mm512_maskz_loadu_ps(k, x + i);
+        __m512 py = _mm512_maskz_loadu_ps(k, y + i);
+        __m512 pz = _mm512_maskz_loadu_ps(k, z + i);
+        __m512 nr = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_maskz_loadu_ps(k, radius + i));
+        __mmask16 outside = 0;
+
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            __m512 d = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(planes[p].x), px), _mm512_mul_ps(_mm512_set1_ps(planes[p].y), py));
+            d = _mm512_add_ps(d, _mm512_mul_ps(_mm512_set1_ps(planes[p].z), pz));
+            d = _mm512_add_ps(d, _mm512_set1_ps(planes[p].w));
+            outside |= _mm512_cmp_ps_mask(d, nr, _CMP_LT_OQ);
+        }
+
+        __m512i flags = _mm512_maskz_set1_epi32((__mmask16)~outside, 1);
+        _mm512_mask_cvtepi32_storeu_epi8(visible + i, k, flags);
+    }
+}
+
+ESGS_TARGET_AVX512 static void encodeSnorm16AVX512(const float* in, int16_t* out, size_t count)
+{
+    __m512 lo = _mm512_set1_ps(-1.0f);
+    __m512 hi = _mm512_set1_ps(1.0f);
+    __m512 scale = _mm512_set1_ps(32767.0f);
+
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 k = tailMask(count - i);
+        //NaN lanes are zeroed first, max/min would turn them into -1
+        __m512 v = _mm512_maskz_loadu_ps(k, in + i);
+        v = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(v, v, _CMP_ORD_Q), v);
+        v = _mm512_mul_ps(_mm512_min_ps(_mm512_max_ps(v, lo), hi), scale);
+        _mm512_mask_cvtsepi32_storeu_epi16(out + i, k, _mm512_cvtps_epi32(v));
+    }
+}
+
+void registerBatchKernelsAVX512(BatchKernelTable& table)
+{
+    table.normalize3 = normalize3AVX512;
+    table.dot3 = dot3AVX512;
+    table.transformPoints = transformPointsAVX512;
+    table.normalizeQuaternions = normalizeQuaternionsAVX512;
+    table.cullSpheres = cullSpheresAVX512;
+    table.encodeSnorm16 = encodeSnorm16AVX512;
+    table.level = SimdLevel::AVX512;
+}
+
+ESGS_STRICT_FLOAT_END
+
+#else
+
+void registerBatchKernelsAVX512(BatchKernelTable&)
+{
+}
+
+#endif
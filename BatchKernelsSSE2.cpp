@@ -0,0 +1,266 @@
+#include "BatchKernels.h"
+#include "TransformBatch.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+#include <cmath>
+
+#ifdef ESGS_SSE2
+
+ESGS_STRICT_FLOAT_BEGIN
+
+static void normalize3SSE2(float* x, float* y, float* z, size_t count)
+{
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 eps = _mm_set1_ps((float)epsilon);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        __m128 valid = _mm_cmpgt_ps(mag, eps);
+        __m128 inv = _mm_div_ps(one, mag);
+        _mm_storeu_ps(x + i, _mm_and_ps(valid, _mm_mul_ps(vx, inv)));
+        _mm_storeu_ps(y + i, _mm_and_ps(valid, _mm_mul_ps(vy, inv)));
+        _mm_storeu_ps(z + i, _mm_and_ps(valid, _mm_mul_ps(vz, inv)));
+    }
+
+    for (; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        if (mag > epsilon)
+        {
+            float inv = 1.0f / mag;
+            x[i] *= inv;
+            y[i] *= inv;
+            z[i] *= inv;
+        }
+        else
+        {
+            x[i] = 0.0f;
+            y[i] = 0.0f;
+            z[i] = 0.0f;
+        }
+    }
+}
+
+static void dot3SSE2(const float* ax, const float* ay, const float* az,
+    const float* bx, const float* by, const float* bz, float* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 d = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(ax + i), _mm_loadu_ps(bx + i)),
+            _mm_mul_ps(_mm_loadu_ps(ay + i), _mm_loadu_ps(by + i))),
+            _mm_mul_ps(_mm_loadu_ps(az + i), _mm_loadu_ps(bz + i)));
+        _mm_storeu_ps(out + i, d);
+    }
+
+    for (; i < count; i++)
+        out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+}
+
+static void transformPointsSSE2(const Matrix4x4& matrix, const float* x, const float* y, const float* z,
+    float* outX, float* outY, float* outZ, size_t count)
+{
+    const float (*m)[4] = matrix.m_mat;
+    float* out[3] = { outX, outY, outZ };
+
+    __m128 c[3][4];
+    for (int col = 0; col < 3; col++)
+    {
+        for (int row = 0; row < 4; row++)
+            c[col][row] = _mm_set1_ps(m[row][col]);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        for (int col = 0; col < 3; col++)
+        {
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, c[col][0]), _mm_mul_ps(py, c[col][1])),
+                _mm_mul_ps(pz, c[col][2])), c[col][3]);
+            _mm_storeu_ps(out[col] + i, r);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        float px = x[i], py = y[i], pz = z[i];
+        outX[i] = px * m[0][0] + py * m[1][0] + pz * m[2][0] + m[3][0];
+        outY[i] = px * m[0][1] + py * m[1][1] + pz * m[2][1] + m[3][1];
+        outZ[i] = px * m[0][2] + py * m[1][2] + pz * m[2][2] + m[3][2];
+    }
+}
+
+static void multiplyMatricesSSE2(const Matrix4x4* a, const Matrix4x4* b, Matrix4x4* out, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        __m128 b0 = _mm_loadu_ps(b[n].m_mat[0]);
+        __m128 b1 = _mm_loadu_ps(b[n].m_mat[1]);
+        __m128 b2 = _mm_loadu_ps(b[n].m_mat[2]);
+        __m128 b3 = _mm_loadu_ps(b[n].m_mat[3]);
+
+        __m128 rows[4];
+        for (int i = 0; i < 4; i++)
+        {
+            const float* r = a[n].m_mat[i];
+            rows[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(r[0]), b0),
+                _mm_mul_ps(_mm_set1_ps(r[1]), b1)),
+                _mm_mul_ps(_mm_set1_ps(r[2]), b2)),
+                _mm_mul_ps(_mm_set1_ps(r[3]), b3));
+        }
+
+        //Stored after all rows are computed so that out may alias a or b
+        for (int i = 0; i < 4; i++)
+            _mm_storeu_ps(out[n].m_mat[i], rows[i]);
+    }
+}
+
+static void normalizeQuaternionsSSE2(float* x, float* y, float* z, float* w, size_t count)
+{
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 eps = _mm_set1_ps((float)epsilon);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 vw = _mm_loadu_ps(w + i);
+        __m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)),
+            _mm_mul_ps(vz, vz)), _mm_mul_ps(vw, vw)));
+        __m128 valid = _mm_cmpnlt_ps(mag, eps);
+        __m128 inv = _mm_and_ps(valid, _mm_div_ps(one, mag));
+        _mm_storeu_ps(x + i, _mm_mul_ps(vx, inv));
+        _mm_storeu_ps(y + i, _mm_mul_ps(vy, inv));
+        _mm_storeu_ps(z + i, _mm_mul_ps(vz, inv));
+        _mm_storeu_ps(w + i, _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(vw, inv)), _mm_andnot_ps(valid, one)));
+    }
+
+    for (; i < count; i++)
+    {
+        float mag = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        float inv = mag < epsilon ? 0.0f : 1.0f / mag;
+        x[i] *= inv;
+        y[i] *= inv;
+        z[i] *= inv;
+        w[i] = mag < epsilon ? 1.0f : w[i] * inv;
+    }
+}
+
+static size_t decomposeTransformsSSE2(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+    Quaternion* rotations, Vector3D* scales, uint8_t* shear)
+{
+    return TransformBatch::decompose(matrices, count, translations, rotations, scales, shear);
+}
+
+static void composeTransformsSSE2(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+    size_t count, Matrix4x4* matrices)
+{
+    TransformBatch::compose(translations, rotations, scales, count, matrices);
+}
+
+static void cullSpheresSSE2(const Vector4D* planes, size_t planeCount, const float* x, const float* y, const float* z,
+    const float* radius, uint8_t* visible, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 nr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 outside = _mm_setzero_ps();
+
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(planes[p].x), px),
+                _mm_mul_ps(_mm_set1_ps(planes[p].y), py)),
+                _mm_mul_ps(_mm_set1_ps(planes[p].z), pz)),
+                _mm_set1_ps(planes[p].w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, nr));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++)
+            visible[i + k] = (uint8_t)(((mask >> k) & 1) ^ 1);
+    }
+
+    for (; i < count; i++)
+    {
+        uint8_t inside = 1;
+        for (size_t p = 0; p < planeCount; p++)
+        {
+            float d = planes[p].x * x[i] + planes[p].y * y[i] + planes[p].z * z[i] + planes[p].w;
+            if (d < -radius[i])
+            {
+                inside = 0;
+                break;
+            }
+        }
+        visible[i] = inside;
+    }
+}
+
+static void encodeSnorm16SSE2(const float* in, int16_t* out, size_t count)
+{
+    __m128 lo = _mm_set1_ps(-1.0f);
+    __m128 hi = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(32767.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        //NaN lanes are zeroed first, max/min would turn them into -1
+        __m128 va = _mm_loadu_ps(in + i);
+        __m128 vb = _mm_loadu_ps(in + i + 4);
+        va = _mm_and_ps(va, _mm_cmpord_ps(va, va));
+        vb = _mm_and_ps(vb, _mm_cmpord_ps(vb, vb));
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(va, lo), hi), scale);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(vb, lo), hi), scale);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128((__m128i*)(out + i), packed);
+    }
+
+    for (; i < count; i++)
+    {
+        float v = in[i];
+        v = v != v ? 0.0f : (v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v));
+        out[i] = (int16_t)lrintf(v * 32767.0f);
+    }
+}
+
+void registerBatchKernelsSSE2(BatchKernelTable& table)
+{
+    table.normalize3 = normalize3SSE2;
+    table.dot3 = dot3SSE2;
+    table.transformPoints = transformPointsSSE2;
+    table.multiplyMatrices = multiplyMatricesSSE2;
+    table.normalizeQuaternions = normalizeQuaternionsSSE2;
+    table.decomposeTransforms = decomposeTransformsSSE2;
+    table.composeTransforms = composeTransformsSSE2;
+    table.cullSpheres = cullSpheresSSE2;
+    table.encodeSnorm16 = encodeSnorm16SSE2;
+    table.level = SimdLevel::SSE2;
+}
+
+ESGS_STRICT_FLOAT_END
+
+#else
+
+void registerBatchKernelsSSE2(BatchKernelTable&)
+{
+}
+
+#endif
@@ -0,0 +1,324 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Quaternion.h"
+#include "Matrix4x4.h"
+#include "TransformBatch.h"
+#include "Export.h"
+
+enum class CameraProjection : uint8_t
+{
+	Perspective,
+	Orthographic
+};
+
+//Owns a camera's pose and projection and every matrix derived from them. Setters only
+//bump a version; the view, projection, their product, the inverses and the frustum
+//planes are rebuilt on first access after a change and returned by const reference.
+//Getters fill caches, so call update() before sharing one camera between threads.
+class ESGS_EXPORT Camera
+{
+public:
+	Camera()
+	{
+	}
+
+	//fov in radians, same parameters as Matrix4x4::setPerspectiveFovLH
+	void setPerspective(float fov, float aspect, float znear, float zfar)
+	{
+		m_projection_type = CameraProjection::Perspective;
+		m_fov = fov;
+		m_aspect = aspect;
+		m_near = znear;
+		m_far = zfar;
+		m_projection_version++;
+	}
+
+	//Same parameters as Matrix4x4::setOrthoLH
+	void setOrthographic(float width, float height, float znear, float zfar)
+	{
+		m_projection_type = CameraProjection::Orthographic;
+		m_width = width;
+		m_height = height;
+		m_near = znear;
+		m_far = zfar;
+		m_projection_version++;
+	}
+
+	void setFov(float fov)
+	{
+		if (fov != m_fov)
+		{
+			m_fov = fov;
+			m_projection_version++;
+		}
+	}
+
+	void setAspect(float aspect)
+	{
+		if (aspect != m_aspect)
+		{
+			m_aspect = aspect;
+			m_projection_version++;
+		}
+	}
+
+	void setClipPlanes(float znear, float zfar)
+	{
+		if (znear != m_near || zfar != m_far)
+		{
+			m_near = znear;
+			m_far = zfar;
+			m_projection_version++;
+		}
+	}
+
+	void setPose(const Vector3D& position, const Quaternion& rotation)
+	{
+		m_position = position;
+		m_rotation = rotation;
+		m_has_world = false;
+		m_pose_version++;
+	}
+
+	void setPosition(const Vector3D& position)
+	{
+		setPose(position, m_rotation);
+	}
+
+	void setRotation(const Quaternion& rotation)
+	{
+		setPose(m_position, rotation);
+	}
+
+	//Camera to world transform, may contain scale
+	void setWorldMatrix(const Matrix4x4& world)
+	{
+		m_world = world;
+		m_has_world = true;
+		m_pose_version++;
+	}
+
+	const Matrix4x4& getWorld() const
+	{
+		updateView();
+		return m_world;
+	}
+
+	const Matrix4x4& getView() const
+	{
+		updateView();
+		return m_view;
+	}
+
+	const Matrix4x4& getInverseView() const
+	{
+		return getWorld();
+	}
+
+	const Matrix4x4& getProjection() const
+	{
+		updateProjection();
+		return m_proj;
+	}
+
+	const Matrix4x4& getInverseProjection() const
+	{
+		updateProjection();
+		return m_inv_proj;
+	}
+
+	const Matrix4x4& getViewProjection() const
+	{
+		updateViewProjection();
+		return m_view_proj;
+	}
+
+	const Matrix4x4& getInverseViewProjection() const
+	{
+		updateViewProjection();
+		return m_inv_view_proj;
+	}
+
+	//left, right, bottom, top, near, far; (normal, d) with the normal pointing inside
+	const Vector4D* getFrustumPlanes() const
+	{
+		updateViewProjection();
+		return m_planes;
+	}
+
+	Vector3D getPosition() const
+	{
+		const Matrix4x4& world = getWorld();
+		return Vector3D(world.m_mat[3][0], world.m_mat[3][1], world.m_mat[3][2]);
+	}
+
+	Vector3D getForward() const
+	{
+		const Matrix4x4& world = getWorld();
+		return Vector3D(world.m_mat[2][0], world.m_mat[2][1], world.m_mat[2][2]);
+	}
+
+	CameraProjection getProjectionType() const { return m_projection_type; }
+	float getFov() const { return m_fov; }
+	float getAspect() const { return m_aspect; }
+	float getNear() const { return m_near; }
+	float getFar() const { return m_far; }
+
+	//Changes with every pose or projection change, for consumers keeping their own caches
+	uint64_t getVersion() const
+	{
+		return m_pose_version + m_projection_version;
+	}
+
+	//Rebuilds whatever is stale
+	void update() const
+	{
+		updateViewProjection();
+	}
+
+	//Gribb-Hartmann extraction for the row-vector convention and D3D clip depth [0, w]
+	static void extractFrustumPlanes(const Matrix4x4& viewProjection, Vector4D planes[6])
+	{
+		const float (*m)[4] = viewProjection.m_mat;
+		for (int i = 0; i < 6; i++)
+		{
+			int axis = i / 2;
+			float sign = (i & 1) ? -1.0f : 1.0f;
+			Vector4D p;
+			if (axis < 2)
+			{
+				p = Vector4D(m[0][3] + sign * m[0][axis], m[1][3] + sign * m[1][axis],
+					m[2][3] + sign * m[2][axis], m[3][3] + sign * m[3][axis]);
+			}
+			else if (i == 4)
+			{
+				p = Vector4D(m[0][2], m[1][2], m[2][2], m[3][2]);
+			}
+			else
+			{
+				p = Vector4D(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]);
+			}
+
+			float len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+			float inv = len > epsilon ? 1.0f / len : 0.0f;
+			planes[i] = Vector4D(p.x * inv, p.y * inv, p.z * inv, p.w * inv);
+		}
+	}
+
+private:
+	void updateView() const
+	{
+		if (m_view_version == m_pose_version)
+			return;
+
+		if (m_has_world)
+		{
+			m_view = m_world;
+			m_view.inverse();
+		}
+		else
+		{
+			TransformBatch::compose(m_position, m_rotation, Vector3D(1.0f, 1.0f, 1.0f), m_world);
+
+			//Rigid inverse: transposed rotation and rotated negative translation
+			const float (*w)[4] = m_world.m_mat;
+			float (*v)[4] = m_view.m_mat;
+			for (int r = 0; r < 3; r++)
+			{
+				for (int c = 0; c < 3; c++)
+					v[r][c] = w[c][r];
+				v[r][3] = 0.0f;
+			}
+			for (int c = 0; c < 3; c++)
+				v[3][c] = -(w[3][0] * w[c][0] + w[3][1] * w[c][1] + w[3][2] * w[c][2]);
+			v[3][3] = 1.0f;
+		}
+
+		m_view_version = m_pose_version;
+	}
+
+	void updateProjection() const
+	{
+		if (m_proj_version == m_projection_version)
+			return;
+
+		m_proj.setIdentity();
+		m_inv_proj.setIdentity();
+		if (m_projection_type == CameraProjection::Perspective)
+		{
+			m_proj.setPerspectiveFovLH(m_fov, m_aspect, m_near, m_far);
+
+			//Closed form of the sparse perspective matrix
+			const float (*p)[4] = m_proj.m_mat;
+			float (*i)[4] = m_inv_proj.m_mat;
+			i[0][0] = 1.0f / p[0][0];
+			i[1][1] = 1.0f / p[1][1];
+			i[2][2] = 0.0f;
+			i[2][3] = 1.0f / p[3][2];
+			i[3][2] = 1.0f;
+			i[3][3] = -p[2][2] / p[3][2];
+		}
+		else
+		{
+			m_proj.setOrthoLH(m_width, m_height, m_near, m_far);
+
+			const float (*p)[4] = m_proj.m_mat;
+			float (*i)[4] = m_inv_proj.m_mat;
+			i[0][0] = 1.0f / p[0][0];
+			i[1][1] = 1.0f / p[1][1];
+			i[2][2] = 1.0f / p[2][2];
+			i[3][2] = -p[3][2] / p[2][2];
+		}
+
+		m_proj_version = m_projection_version;
+	}
+
+	void updateViewProjection() const
+	{
+		updateView();
+		updateProjection();
+		if (m_view_proj_pose == m_pose_version && m_view_proj_projection == m_projection_version)
+			return;
+
+		m_view_proj = m_view;
+		m_view_proj *= m_proj;
+		m_inv_view_proj = m_inv_proj;
+		m_inv_view_proj *= m_world;
+		extractFrustumPlanes(m_view_proj, m_planes);
+
+		m_view_proj_pose = m_pose_version;
+		m_view_proj_projection = m_projection_version;
+	}
+
+	CameraProjection m_projection_type = CameraProjection::Perspective;
+	float m_fov = 1.57079632679f;
+	float m_aspect = 1.0f;
+	float m_width = 1.0f;
+	float m_height = 1.0f;
+	float m_near = 0.1f;
+	float m_far = 1000.0f;
+
+	Vector3D m_position;
+	Quaternion m_rotation = Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+	bool m_has_world = false;
+
+	//Source versions start at 1 and caches at 0 so the first access builds everything
+	uint64_t m_pose_version = 1;
+	uint64_t m_projection_version = 1;
+
+	mutable uint64_t m_view_version = 0;
+	mutable uint64_t m_proj_version = 0;
+	mutable uint64_t m_view_proj_pose = 0;
+	mutable uint64_t m_view_proj_projection = 0;
+
+	mutable Matrix4x4 m_world;
+	mutable Matrix4x4 m_view;
+	mutable Matrix4x4 m_proj;
+	mutable Matrix4x4 m_inv_proj;
+	mutable Matrix4x4 m_view_proj;
+	mutable Matrix4x4 m_inv_view_proj;
+	mutable Vector4D m_planes[6];
+};
@@ -0,0 +1,286 @@
+#include "ClusterGrid.h"
+#include "BatchKernels.h"
+#include "AsyncCore.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+enum ClusterComponent
+{
+    LightX,
+    LightY,
+    LightZ,
+    LightRadius,
+    LightDirX,
+    LightDirY,
+    LightDirZ,
+    LightCos,
+    LightSin,
+    LightComponents
+};
+
+static float sphereBoundsDistanceSq(float x, float y, float z, float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+{
+    float dx = std::max(0.0f, std::max(minX - x, x - maxX));
+    float dy = std::max(0.0f, std::max(minY - y, y - maxY));
+    float dz = std::max(0.0f, std::max(minZ - z, z - maxZ));
+    return dx * dx + dy * dy + dz * dz;
+}
+
+ClusterGrid::ClusterGrid(uint32_t tilesX, uint32_t tilesY, uint32_t slices) :
+    m_tiles_x(tilesX ? tilesX : 1), m_tiles_y(tilesY ? tilesY : 1), m_slices(slices ? slices : 1)
+{
+    m_log_ratio = logf(m_far / m_near);
+    m_slice_data.resize(m_slices);
+    m_offsets.assign(getClusterCount() + 1, 0);
+}
+
+bool ClusterGrid::setProjection(const Matrix4x4& projection)
+{
+    const float (*p)[4] = projection.m_mat;
+    if (p[2][3] != 1.0f || p[3][3] != 0.0f || p[0][0] <= 0.0f || p[1][1] <= 0.0f || p[2][2] == 0.0f || p[2][2] == 1.0f)
+        return false;
+
+    //m22 = f / (f - n), m32 = -n * f / (f - n)
+    float znear = -p[3][2] / p[2][2];
+    float zfar = p[3][2] / (1.0f - p[2][2]);
+    if (!(znear > 0.0f) || !(zfar > znear))
+        return false;
+
+    m_x_scale = p[0][0];
+    m_y_scale = p[1][1];
+    m_near = znear;
+    m_far = zfar;
+    m_log_ratio = logf(zfar / znear);
+    return true;
+}
+
+uint32_t ClusterGrid::getSlice(float viewZ) const
+{
+    if (!(viewZ > m_near))
+        return 0;
+    float k = logf(viewZ / m_near) / m_log_ratio * (float)m_slices;
+    return k >= (float)(m_slices - 1) ? m_slices - 1 : (uint32_t)k;
+}
+
+float ClusterGrid::getSliceDepth(uint32_t slice) const
+{
+    return m_near * powf(m_far / m_near, (float)slice / (float)m_slices);
+}
+
+ClusterGrid::Bounds ClusterGrid::getBounds(uint32_t tileX0, uint32_t tileX1, uint32_t tileY, uint32_t slice) const
+{
+    float zn = getSliceDepth(slice);
+    float zf = getSliceDepth(slice + 1);
+    float x0 = -1.0f + 2.0f * (float)tileX0 / (float)m_tiles_x;
+    float x1 = -1.0f + 2.0f * (float)tileX1 / (float)m_tiles_x;
+    float y0 = 1.0f - 2.0f * (float)(tileY + 1) / (float)m_tiles_y;
+    float y1 = 1.0f - 2.0f * (float)tileY / (float)m_tiles_y;
+
+    //View space x = ndc x * z / xscale, extremes lie on the near or far depth
+    Bounds b;
+    b.minX = std::min(x0 * zn, x0 * zf) / m_x_scale;
+    b.maxX = std::max(x1 * zn, x1 * zf) / m_x_scale;
+    b.minY = std::min(y0 * zn, y0 * zf) / m_y_scale;
+    b.maxY = std::max(y1 * zn, y1 * zf) / m_y_scale;
+    b.minZ = zn;
+    b.maxZ = zf;
+    return b;
+}
+
+void ClusterGrid::assign(const Matrix4x4& view, const ClusterLights& lights)
+{
+    size_t n = lights.count;
+    for (std::vector<float>& component : m_view)
+        component.resize(n);
+
+    BatchKernels::get().transformPoints(view, lights.x, lights.y, lights.z,
+        m_view[LightX].data(), m_view[LightY].data(), m_view[LightZ].data(), n);
+
+    const float (*m)[4] = view.m_mat;
+    for (size_t i = 0; i < n; i++)
+    {
+        m_view[LightRadius][i] = lights.radius[i];
+        if (lights.dirX)
+        {
+            float dx = lights.dirX[i], dy = lights.dirY[i], dz = lights.dirZ[i];
+            m_view[LightDirX][i] = dx * m[0][0] + dy * m[1][0] + dz * m[2][0];
+            m_view[LightDirY][i] = dx * m[0][1] + dy * m[1][1] + dz * m[2][1];
+            m_view[LightDirZ][i] = dx * m[0][2] + dy * m[1][2] + dz * m[2][2];
+            m_view[LightCos][i] = lights.cosAngle[i];
+            m_view[LightSin][i] = lights.sinAngle[i];
+        }
+        else
+        {
+            m_view[LightDirX][i] = 0.0f;
+            m_view[LightDirY][i] = 0.0f;
+            m_view[LightDirZ][i] = 0.0f;
+            m_view[LightCos][i] = -1.0f;
+            m_view[LightSin][i] = 0.0f;
+        }
+    }
+
+    //Bucket by the slices each light's depth range touches
+    for (Slice& slice : m_slice_data)
+        slice.lights.clear();
+    for (size_t i = 0; i < n; i++)
+    {
+        float z = m_view[LightZ][i];
+        float r = m_view[LightRadius][i];
+        if (!(r > 0.0f) || z + r < m_near || z - r > m_far)
+            continue;
+        uint32_t last = getSlice(z + r);
+        for (uint32_t s = getSlice(z - r); s <= last; s++)
+            m_slice_data[s].lights.push_back((uint32_t)i);
+    }
+
+    __parallel_for(m_slices, 1, [this](size_t begin, size_t end)
+    {
+        for (size_t s = begin; s < end; s++)
+            assignSlice((uint32_t)s);
+    });
+
+    uint32_t tiles = m_tiles_x * m_tiles_y;
+    m_offsets.resize(getClusterCount() + 1);
+    uint32_t total = 0;
+    for (uint32_t s = 0; s < m_slices; s++)
+    {
+        const Slice& slice = m_slice_data[s];
+        for (uint32_t t = 0; t < tiles; t++)
+        {
+            m_offsets[s * tiles + t] = total;
+            total += slice.counts[t];
+        }
+    }
+    m_offsets[getClusterCount()] = total;
+
+    m_indices.resize(total);
+    for (uint32_t s = 0; s < m_slices; s++)
+    {
+        const Slice& slice = m_slice_data[s];
+        if (!slice.indices.empty())
+            ::memcpy(m_indices.data() + m_offsets[s * tiles], slice.indices.data(), slice.indices.size() * sizeof(uint32_t));
+    }
+}
+
+void ClusterGrid::assignSlice(uint32_t s)
+{
+    Slice& slice = m_slice_data[s];
+    slice.counts.assign(m_tiles_x * m_tiles_y, 0);
+    slice.indices.clear();
+    if (slice.lights.empty())
+        return;
+
+    const float* vx = m_view[LightX].data();
+    const float* vy = m_view[LightY].data();
+    const float* vz = m_view[LightZ].data();
+    const float* vr = m_view[LightRadius].data();
+
+    for (uint32_t ty = 0; ty < m_tiles_y; ty++)
+    {
+        //Coarse pass against the whole row of tiles
+        Bounds row = getBounds(0, m_tiles_x, ty, s);
+        slice.rowLights.clear();
+        for (uint32_t i : slice.lights)
+        {
+            if (sphereBoundsDistanceSq(vx[i], vy[i], vz[i], row.minX, row.minY, row.minZ, row.maxX, row.maxY, row.maxZ) <= vr[i] * vr[i])
+                slice.rowLights.push_back(i);
+        }
+        if (slice.rowLights.empty())
+            continue;
+
+        //Gather into padded SoA, padding lights are too far away to hit anything
+        size_t count = slice.rowLights.size();
+        size_t stride = (count + 3) & ~(size_t)3;
+        slice.gather.resize(stride * LightComponents);
+        float* g = slice.gather.data();
+        for (int c = 0; c < LightComponents; c++)
+        {
+            const float* src = m_view[c].data();
+            float* dst = g + c * stride;
+            for (size_t j = 0; j < count; j++)
+                dst[j] = src[slice.rowLights[j]];
+            for (size_t j = count; j < stride; j++)
+                dst[j] = c <= LightZ ? FLT_MAX : 0.0f;
+        }
+
+        for (uint32_t tx = 0; tx < m_tiles_x; tx++)
+        {
+            Bounds b = getBounds(tx, tx + 1, ty, s);
+            float cx = 0.5f * (b.minX + b.maxX), cy = 0.5f * (b.minY + b.maxY), cz = 0.5f * (b.minZ + b.maxZ);
+            float ex = b.maxX - cx, ey = b.maxY - cy, ez = b.maxZ - cz;
+            float radius = sqrtf(ex * ex + ey * ey + ez * ez);
+            uint32_t& tileCount = slice.counts[ty * m_tiles_x + tx];
+
+            //Sphere against the cluster box, then the cone against the cluster's bounding
+            //sphere: culled when the sphere lies outside the cone angle, beyond the
+            //range or behind the apex
+#ifdef ESGS_SSE2
+            __m128 minX = _mm_set1_ps(b.minX), minY = _mm_set1_ps(b.minY), minZ = _mm_set1_ps(b.minZ);
+            __m128 maxX = _mm_set1_ps(b.maxX), maxY = _mm_set1_ps(b.maxY), maxZ = _mm_set1_ps(b.maxZ);
+            __m128 centerX = _mm_set1_ps(cx), centerY = _mm_set1_ps(cy), centerZ = _mm_set1_ps(cz);
+            __m128 clusterRadius = _mm_set1_ps(radius);
+            __m128 negClusterRadius = _mm_set1_ps(-radius);
+            __m128 zero = _mm_setzero_ps();
+            for (size_t j = 0; j < stride; j += 4)
+            {
+                __m128 px = _mm_loadu_ps(g + LightX * stride + j);
+                __m128 py = _mm_loadu_ps(g + LightY * stride + j);
+                __m128 pz = _mm_loadu_ps(g + LightZ * stride + j);
+                __m128 r = _mm_loadu_ps(g + LightRadius * stride + j);
+                __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minX, px), _mm_sub_ps(px, maxX)));
+                __m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minY, py), _mm_sub_ps(py, maxY)));
+                __m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minZ, pz), _mm_sub_ps(pz, maxZ)));
+                __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 hit = _mm_cmple_ps(distSq, _mm_mul_ps(r, r));
+                if (!_mm_movemask_ps(hit))
+                    continue;
+
+                __m128 ox = _mm_sub_ps(centerX, px);
+                __m128 oy = _mm_sub_ps(centerY, py);
+                __m128 oz = _mm_sub_ps(centerZ, pz);
+                __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+                __m128 along = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(ox, _mm_loadu_ps(g + LightDirX * stride + j)),
+                    _mm_mul_ps(oy, _mm_loadu_ps(g + LightDirY * stride + j))),
+                    _mm_mul_ps(oz, _mm_loadu_ps(g + LightDirZ * stride + j)));
+                __m128 across = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(lenSq, _mm_mul_ps(along, along))));
+                __m128 closest = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(g + LightCos * stride + j), across),
+                    _mm_mul_ps(_mm_loadu_ps(g + LightSin * stride + j), along));
+                __m128 cull = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(closest, clusterRadius),
+                    _mm_cmpgt_ps(along, _mm_add_ps(clusterRadius, r))), _mm_cmplt_ps(along, negClusterRadius));
+
+                int mask = _mm_movemask_ps(_mm_andnot_ps(cull, hit));
+                for (int k = 0; k < 4; k++)
+                {
+                    if (mask & (1 << k))
+                    {
+                        slice.indices.push_back(slice.rowLights[j + k]);
+                        tileCount++;
+                    }
+                }
+            }
+#else
+            for (size_t j = 0; j < count; j++)
+            {
+                float px = g[LightX * stride + j], py = g[LightY * stride + j], pz = g[LightZ * stride + j];
+                float r = g[LightRadius * stride + j];
+                if (sphereBoundsDistanceSq(px, py, pz, b.minX, b.minY, b.minZ, b.maxX, b.maxY, b.maxZ) > r * r)
+                    continue;
+
+                float ox = cx - px, oy = cy - py, oz = cz - pz;
+                float along = ox * g[LightDirX * stride + j] + oy * g[LightDirY * stride + j] + oz * g[LightDirZ * stride + j];
+                float across = sqrtf(std::max(0.0f, ox * ox + oy * oy + oz * oz - along * along));
+                float closest = g[LightCos * stride + j] * across - g[LightSin * stride + j] * along;
+                if (closest > radius || along > radius + r || along < -radius)
+                    continue;
+
+                slice.indices.push_back(slice.rowLights[j]);
+                tileCount++;
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Matrix4x4.h"
+#include "Export.h"
+
+//World space light bounds as structure of arrays. Sphere lights leave the cone arrays
+//null; decals and other volumes are passed as their bounding spheres.
+struct ClusterLights
+{
+	const float* x = nullptr;
+	const float* y = nullptr;
+	const float* z = nullptr;
+	const float* radius = nullptr;
+
+	//Optional spot cones: normalized direction and the outer half-angle as cos/sin
+	const float* dirX = nullptr;
+	const float* dirY = nullptr;
+	const float* dirZ = nullptr;
+	const float* cosAngle = nullptr;
+	const float* sinAngle = nullptr;
+
+	size_t count = 0;
+};
+
+//Froxel grid for clustered shading. Screen tiles are split into depth slices with
+//exponential spacing between the projection's near and far planes. assign() bins
+//lights per slice in parallel and produces a compact index list per cluster:
+//cluster c uses getIndices()[getOffsets()[c] .. getOffsets()[c + 1]).
+//Buffers are kept between frames, so steady frames do not allocate.
+class ESGS_EXPORT ClusterGrid
+{
+public:
+	ClusterGrid(uint32_t tilesX = 16, uint32_t tilesY = 9, uint32_t slices = 24);
+
+	//Perspective matrix from Matrix4x4::setPerspectiveFovLH. Returns false and keeps the
+	//previous grid when the matrix is not a left handed perspective projection.
+	bool setProjection(const Matrix4x4& projection);
+
+	//view transforms world space to the camera space of the projection
+	void assign(const Matrix4x4& view, const ClusterLights& lights);
+
+	uint32_t getTilesX() const { return m_tiles_x; }
+	uint32_t getTilesY() const { return m_tiles_y; }
+	uint32_t getSlices() const { return m_slices; }
+	uint32_t getClusterCount() const { return m_tiles_x * m_tiles_y * m_slices; }
+
+	//Slice major: (slice * tilesY + tileY) * tilesX + tileX, tile 0 is the top left
+	uint32_t getClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const
+	{
+		return (slice * m_tiles_y + tileY) * m_tiles_x + tileX;
+	}
+
+	//Slice containing a view space depth, clamped to the grid
+	uint32_t getSlice(float viewZ) const;
+	//View space depth where slice begins, getSliceDepth(getSlices()) is the far plane
+	float getSliceDepth(uint32_t slice) const;
+
+	const uint32_t* getLights(uint32_t cluster, uint32_t& count) const
+	{
+		count = m_offsets[cluster + 1] - m_offsets[cluster];
+		return m_indices.data() + m_offsets[cluster];
+	}
+
+	const std::vector<uint32_t>& getOffsets() const { return m_offsets; }
+	const std::vector<uint32_t>& getIndices() const { return m_indices; }
+
+private:
+	struct Bounds
+	{
+		float minX, minY, minZ;
+		float maxX, maxY, maxZ;
+	};
+
+	//Per slice working set, reused every frame
+	struct Slice
+	{
+		std::vector<uint32_t> lights;
+		std::vector<uint32_t> rowLights;
+		std::vector<float> gather;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> indices;
+	};
+
+	Bounds getBounds(uint32_t tileX0, uint32_t tileX1, uint32_t tileY, uint32_t slice) const;
+	void assignSlice(uint32_t slice);
+
+	uint32_t m_tiles_x;
+	uint32_t m_tiles_y;
+	uint32_t m_slices;
+
+	float m_x_scale = 1.0f;
+	float m_y_scale = 1.0f;
+	float m_near = 0.1f;
+	float m_far = 1000.0f;
+	float m_log_ratio = 1.0f;
+
+	//View space lights, cone lights use (dir, cos, sin), spheres (0, -1, 0)
+	std::vector<float> m_view[9];
+	std::vector<Slice> m_slice_data;
+
+	std::vector<uint32_t> m_offsets;
+	std::vector<uint32_t> m_indices;
+};
@@ -0,0 +1,136 @@
+#include "CpuFeatures.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define ESGS_X86 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define ESGS_X86 1
+#endif
+
+#ifdef ESGS_X86
+static void cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i = 0; i < 4; i++)
+        regs[i] = (unsigned int)r[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static CpuFeatureFlags detect()
+{
+    CpuFeatureFlags flags;
+
+#ifdef ESGS_X86
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    flags.sse2 = (regs[3] & (1u << 26)) != 0;
+    flags.sse41 = (regs[2] & (1u << 19)) != 0;
+    flags.sse42 = (regs[2] & (1u << 20)) != 0;
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+
+    //The OS has to save the YMM/ZMM state, otherwise the instructions fault
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool ymm = (xcr0 & 0x6) == 0x6;
+    bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    flags.avx = avx && ymm;
+    flags.fma = fma && ymm;
+
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, regs);
+        flags.avx2 = flags.avx && (regs[1] & (1u << 5)) != 0;
+        flags.avx512f = zmm && (regs[1] & (1u << 16)) != 0;
+        flags.avx512bw = zmm && (regs[1] & (1u << 30)) != 0;
+    }
+#endif
+
+    return flags;
+}
+
+const CpuFeatureFlags& CpuFeatures::getFlags()
+{
+    static const CpuFeatureFlags flags = detect();
+    return flags;
+}
+
+SimdLevel CpuFeatures::getSupportedLevel()
+{
+    const CpuFeatureFlags& flags = getFlags();
+    if (flags.avx512f && flags.avx512bw && flags.avx2 && flags.fma)
+        return SimdLevel::AVX512;
+    if (flags.avx2 && flags.fma)
+        return SimdLevel::AVX2;
+    if (flags.sse2)
+        return SimdLevel::SSE2;
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel readLevel()
+{
+    SimdLevel level = CpuFeatures::getSupportedLevel();
+
+    const char* env = std::getenv("ESGS_SIMD_LEVEL");
+    if (!env)
+        return level;
+
+    SimdLevel requested = level;
+    if (std::strcmp(env, "scalar") == 0)
+        requested = SimdLevel::Scalar;
+    else if (std::strcmp(env, "sse2") == 0)
+        requested = SimdLevel::SSE2;
+    else if (std::strcmp(env, "avx2") == 0)
+        requested = SimdLevel::AVX2;
+    else if (std::strcmp(env, "avx512") == 0)
+        requested = SimdLevel::AVX512;
+
+    return (int)requested < (int)level ? requested : level;
+}
+
+SimdLevel CpuFeatures::getLevel()
+{
+    static const SimdLevel level = readLevel();
+    return level;
+}
+
+const char* CpuFeatures::getLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE2:
+        return "sse2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    }
+    return "unknown";
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Export.h"
+
+enum class SimdLevel : int
+{
+	Scalar = 0,
+	SSE2 = 1,
+	AVX2 = 2,
+	//AVX-512 F and BW, the kernels are compiled for both (ESGS_TARGET_AVX512)
+	AVX512 = 3
+};
+
+struct CpuFeatureFlags
+{
+	bool sse2 = false;
+	bool sse41 = false;
+	bool sse42 = false;
+	bool avx = false;
+	bool avx2 = false;
+	bool fma = false;
+	bool avx512f = false;
+	bool avx512bw = false;
+};
+
+//Detected once on first use. ESGS_SIMD_LEVEL=scalar|sse2|avx2|avx512 lowers the
+//reported level for testing, it never raises it above what the CPU supports.
+class ESGS_EXPORT CpuFeatures
+{
+public:
+	static const CpuFeatureFlags& getFlags();
+
+	//Highest level supported by the CPU and the OS
+	static SimdLevel getSupportedLevel();
+
+	//Supported level capped by ESGS_SIMD_LEVEL
+	static SimdLevel getLevel();
+
+	static const char* getLevelName(SimdLevel level);
+};
@@ -0,0 +1,525 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "Vector3D.h"
+#include "Quaternion.h"
+#include "FrameArena.h"
+#include "Export.h"
+
+enum class CurveInterpolation : uint8_t
+{
+	Step,
+	Linear,
+	Hermite,
+	Bezier
+};
+
+struct CurveKeyframe
+{
+	float time = 0;
+	float value = 0;
+	//Slope for Hermite, absolute control point value for Bezier
+	float inTangent = 0;
+	//Slope for Hermite, absolute control point value for Bezier
+	float outTangent = 0;
+};
+
+//Cached segment of one playing instance. Keep one per instance and track.
+struct CurveCursor
+{
+	uint32_t key = 0;
+};
+
+namespace curve_detail
+{
+	//Returns segment i with times[i] <= time < times[i + 1]. Forward playback
+	//resolves in a few compares from the cached key, jumps fall back to binary search.
+	inline uint32_t locate(const float* times, uint32_t count, float time, CurveCursor& cursor)
+	{
+		if (count < 2)
+			return 0;
+
+		uint32_t last = count - 2;
+		uint32_t k = cursor.key > last ? last : cursor.key;
+
+		if (time >= times[k])
+		{
+			for (int step = 0; step < 4 && k < last && time >= times[k + 1]; step++)
+				k++;
+
+			if (k < last && time >= times[k + 1])
+			{
+				k = uint32_t(std::upper_bound(times + k + 1, times + count, time) - times) - 1;
+				if (k > last)
+					k = last;
+			}
+		}
+		else
+		{
+			k = uint32_t(std::upper_bound(times, times + k, time) - times);
+			k = k == 0 ? 0 : k - 1;
+		}
+
+		cursor.key = k;
+		return k;
+	}
+
+	inline float segmentFactor(const float* times, uint32_t count, uint32_t k, float time)
+	{
+		if (count < 2)
+			return 0.0f;
+
+		//Keys sharing a time form a step, the later key wins from that time on
+		float span = times[k + 1] - times[k];
+		if (!(span > 0.0f))
+			return time >= times[k + 1] ? 1.0f : 0.0f;
+
+		float t = (time - times[k]) / span;
+		return t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+	}
+
+	//Inserts time keeping the array sorted and returns the index of the new key
+	inline size_t insertTime(std::vector<float>& times, float time)
+	{
+		size_t index = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+		times.insert(times.begin() + index, time);
+		return index;
+	}
+}
+
+class ESGS_EXPORT FloatCurve
+{
+public:
+	FloatCurve()
+	{
+	}
+
+	FloatCurve(CurveInterpolation interpolation) : m_interpolation(interpolation)
+	{
+	}
+
+	void addKey(const CurveKeyframe& key)
+	{
+		size_t index = curve_detail::insertTime(m_times, key.time);
+		m_values.insert(m_values.begin() + index, key.value);
+		m_in_tangents.insert(m_in_tangents.begin() + index, key.inTangent);
+		m_out_tangents.insert(m_out_tangents.begin() + index, key.outTangent);
+	}
+
+	void addKey(float time, float value, float inTangent = 0, float outTangent = 0)
+	{
+		CurveKeyframe key;
+		key.time = time;
+		key.value = value;
+		key.inTangent = inTangent;
+		key.outTangent = outTangent;
+		addKey(key);
+	}
+
+	float sample(float time, CurveCursor& cursor) const
+	{
+		uint32_t count = (uint32_t)m_times.size();
+		if (count == 0)
+			return 0.0f;
+		if (count == 1)
+			return m_values[0];
+
+		uint32_t k = curve_detail::locate(m_times.data(), count, time, cursor);
+		float t = curve_detail::segmentFactor(m_times.data(), count, k, time);
+		return evaluate(k, t);
+	}
+
+	float sample(float time) const
+	{
+		CurveCursor cursor;
+		cursor.key = (uint32_t)m_times.size();
+		return sample(time, cursor);
+	}
+
+	void setInterpolation(CurveInterpolation interpolation)
+	{
+		m_interpolation = interpolation;
+	}
+
+	CurveInterpolation getInterpolation() const
+	{
+		return m_interpolation;
+	}
+
+	size_t getKeyCount() const
+	{
+		return m_times.size();
+	}
+
+	float getStartTime() const
+	{
+		return m_times.empty() ? 0.0f : m_times.front();
+	}
+
+	float getEndTime() const
+	{
+		return m_times.empty() ? 0.0f : m_times.back();
+	}
+
+	void clear()
+	{
+		m_times.clear();
+		m_values.clear();
+		m_in_tangents.clear();
+		m_out_tangents.clear();
+	}
+
+private:
+	float evaluate(uint32_t k, float t) const
+	{
+		float v0 = m_values[k];
+		float v1 = m_values[k + 1];
+
+		switch (m_interpolation)
+		{
+		case CurveInterpolation::Step:
+			return t < 1.0f ? v0 : v1;
+		case CurveInterpolation::Linear:
+			return v0 + (v1 - v0) * t;
+		case CurveInterpolation::Hermite:
+		{
+			float dt = m_times[k + 1] - m_times[k];
+			float t2 = t * t;
+			float t3 = t2 * t;
+			float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+			float h10 = t3 - 2.0f * t2 + t;
+			float h01 = -2.0f * t3 + 3.0f * t2;
+			float h11 = t3 - t2;
+			return h00 * v0 + h10 * dt * m_out_tangents[k] + h01 * v1 + h11 * dt * m_in_tangents[k + 1];
+		}
+		case CurveInterpolation::Bezier:
+		{
+			float u = 1.0f - t;
+			float c1 = m_out_tangents[k];
+			float c2 = m_in_tangents[k + 1];
+			return u * u * u * v0 + 3.0f * u * u * t * c1 + 3.0f * u * t * t * c2 + t * t * t * v1;
+		}
+		}
+
+		return v0;
+	}
+
+private:
+	CurveInterpolation m_interpolation = CurveInterpolation::Linear;
+
+	std::vector<float> m_times;
+	std::vector<float> m_values;
+	std::vector<float> m_in_tangents;
+	std::vector<float> m_out_tangents;
+};
+
+class ESGS_EXPORT Vector3DCurve
+{
+public:
+	Vector3DCurve()
+	{
+	}
+
+	Vector3DCurve(CurveInterpolation interpolation) : m_interpolation(interpolation)
+	{
+	}
+
+	void addKey(float time, const Vector3D& value)
+	{
+		size_t index = curve_detail::insertTime(m_times, time);
+		m_values.insert(m_values.begin() + index, value);
+	}
+
+	//Only Step and Linear are meaningful here, other modes fall back to Linear
+	Vector3D sample(float time, CurveCursor& cursor) const
+	{
+		uint32_t count = (uint32_t)m_times.size();
+		if (count == 0)
+			return Vector3D();
+		if (count == 1)
+			return m_values[0];
+
+		uint32_t k = curve_detail::locate(m_times.data(), count, time, cursor);
+		float t = curve_detail::segmentFactor(m_times.data(), count, k, time);
+
+		if (m_interpolation == CurveInterpolation::Step)
+			return t < 1.0f ? m_values[k] : m_values[k + 1];
+		return Vector3D::lerp(m_values[k], m_values[k + 1], t);
+	}
+
+	Vector3D sample(float time) const
+	{
+		CurveCursor cursor;
+		cursor.key = (uint32_t)m_times.size();
+		return sample(time, cursor);
+	}
+
+	void setInterpolation(CurveInterpolation interpolation)
+	{
+		m_interpolation = interpolation;
+	}
+
+	size_t getKeyCount() const
+	{
+		return m_times.size();
+	}
+
+	float getEndTime() const
+	{
+		return m_times.empty() ? 0.0f : m_times.back();
+	}
+
+	void clear()
+	{
+		m_times.clear();
+		m_values.clear();
+	}
+
+private:
+	CurveInterpolation m_interpolation = CurveInterpolation::Linear;
+
+	std::vector<float> m_times;
+	std::vector<Vector3D> m_values;
+};
+
+class ESGS_EXPORT QuaternionCurve
+{
+public:
+	QuaternionCurve()
+	{
+	}
+
+	QuaternionCurve(CurveInterpolation interpolation) : m_interpolation(interpolation)
+	{
+	}
+
+	//Keys are flipped on insertion so that neighbours always take the shortest arc
+	void addKey(float time, const Quaternion& value)
+	{
+		size_t index = curve_detail::insertTime(m_times, time);
+		m_values.insert(m_values.begin() + index, value);
+
+		for (size_t i = index > 0 ? index : 1; i < m_values.size(); i++)
+		{
+			if (m_values[i - 1].dot(m_values[i]) < 0.0f)
+				m_values[i] = m_values[i] * -1.0f;
+		}
+	}
+
+	//Only Step and Linear (slerp) are meaningful here, other modes fall back to slerp
+	Quaternion sample(float time, CurveCursor& cursor) const
+	{
+		uint32_t count = (uint32_t)m_times.size();
+		if (count == 0)
+			return Quaternion::identity();
+		if (count == 1)
+			return m_values[0];
+
+		uint32_t k = curve_detail::locate(m_times.data(), count, time, cursor);
+		float t = curve_detail::segmentFactor(m_times.data(), count, k, time);
+
+		if (m_interpolation == CurveInterpolation::Step)
+			return t < 1.0f ? m_values[k] : m_values[k + 1];
+
+		Quaternion from = m_values[k];
+		return from.slerp(m_values[k + 1], t);
+	}
+
+	Quaternion sample(float time) const
+	{
+		CurveCursor cursor;
+		cursor.key = (uint32_t)m_times.size();
+		return sample(time, cursor);
+	}
+
+	void setInterpolation(CurveInterpolation interpolation)
+	{
+		m_interpolation = interpolation;
+	}
+
+	size_t getKeyCount() const
+	{
+		return m_times.size();
+	}
+
+	float getEndTime() const
+	{
+		return m_times.empty() ? 0.0f : m_times.back();
+	}
+
+	void clear()
+	{
+		m_times.clear();
+		m_values.clear();
+	}
+
+private:
+	CurveInterpolation m_interpolation = CurveInterpolation::Linear;
+
+	std::vector<float> m_times;
+	std::vector<Quaternion> m_values;
+};
+
+//Per instance playback state of a CurveClip
+struct CurveClipCursor
+{
+	std::vector<CurveCursor> floats;
+	std::vector<CurveCursor> vectors;
+	std::vector<CurveCursor> rotations;
+};
+
+//Structure of arrays output, one entry per track in track order
+struct CurveClipSample
+{
+	std::vector<float> floats;
+
+	std::vector<float> vx;
+	std::vector<float> vy;
+	std::vector<float> vz;
+
+	std::vector<float> qx;
+	std::vector<float> qy;
+	std::vector<float> qz;
+	std::vector<float> qw;
+};
+
+//Same layout as CurveClipSample in FrameArena memory, valid until the arena is reset
+struct CurveClipFrame
+{
+	float* floats = nullptr;
+
+	float* vx = nullptr;
+	float* vy = nullptr;
+	float* vz = nullptr;
+
+	float* qx = nullptr;
+	float* qy = nullptr;
+	float* qz = nullptr;
+	float* qw = nullptr;
+};
+
+class ESGS_EXPORT CurveClip
+{
+public:
+	CurveClip()
+	{
+	}
+
+	uint32_t addFloatTrack(const FloatCurve& curve)
+	{
+		m_floats.push_back(curve);
+		return (uint32_t)m_floats.size() - 1;
+	}
+
+	uint32_t addVectorTrack(const Vector3DCurve& curve)
+	{
+		m_vectors.push_back(curve);
+		return (uint32_t)m_vectors.size() - 1;
+	}
+
+	uint32_t addRotationTrack(const QuaternionCurve& curve)
+	{
+		m_rotations.push_back(curve);
+		return (uint32_t)m_rotations.size() - 1;
+	}
+
+	void resetCursor(CurveClipCursor& cursor) const
+	{
+		cursor.floats.assign(m_floats.size(), CurveCursor());
+		cursor.vectors.assign(m_vectors.size(), CurveCursor());
+		cursor.rotations.assign(m_rotations.size(), CurveCursor());
+	}
+
+	//Evaluates every track at one time. Output buffers are resized only when the
+	//track layout changes, so steady playback does not allocate.
+	void sample(float time, CurveClipCursor& cursor, CurveClipSample& out) const
+	{
+		out.floats.resize(m_floats.size());
+		out.vx.resize(m_vectors.size());
+		out.vy.resize(m_vectors.size());
+		out.vz.resize(m_vectors.size());
+		out.qx.resize(m_rotations.size());
+		out.qy.resize(m_rotations.size());
+		out.qz.resize(m_rotations.size());
+		out.qw.resize(m_rotations.size());
+		sampleInto(time, cursor, out.floats.data(), out.vx.data(), out.vy.data(), out.vz.data(),
+			out.qx.data(), out.qy.data(), out.qz.data(), out.qw.data());
+	}
+
+	//Output in per-frame arena memory instead of per-instance vectors
+	CurveClipFrame sample(float time, CurveClipCursor& cursor, FrameArena& arena) const
+	{
+		CurveClipFrame out;
+		out.floats = arena.allocate<float>(m_floats.size());
+		out.vx = arena.allocate<float>(m_vectors.size());
+		out.vy = arena.allocate<float>(m_vectors.size());
+		out.vz = arena.allocate<float>(m_vectors.size());
+		out.qx = arena.allocate<float>(m_rotations.size());
+		out.qy = arena.allocate<float>(m_rotations.size());
+		out.qz = arena.allocate<float>(m_rotations.size());
+		out.qw = arena.allocate<float>(m_rotations.size());
+		sampleInto(time, cursor, out.floats, out.vx, out.vy, out.vz, out.qx, out.qy, out.qz, out.qw);
+		return out;
+	}
+
+	float getDuration() const
+	{
+		float duration = 0.0f;
+		for (const FloatCurve& c : m_floats)
+			duration = std::max(duration, c.getEndTime());
+		for (const Vector3DCurve& c : m_vectors)
+			duration = std::max(duration, c.getEndTime());
+		for (const QuaternionCurve& c : m_rotations)
+			duration = std::max(duration, c.getEndTime());
+		return duration;
+	}
+
+	size_t getFloatTrackCount() const
+	{
+		return m_floats.size();
+	}
+
+	size_t getVectorTrackCount() const
+	{
+		return m_vectors.size();
+	}
+
+	size_t getRotationTrackCount() const
+	{
+		return m_rotations.size();
+	}
+
+private:
+	void sampleInto(float time, CurveClipCursor& cursor, float* floats, float* vx, float* vy, float* vz,
+		float* qx, float* qy, float* qz, float* qw) const
+	{
+		if (cursor.floats.size() != m_floats.size() || cursor.vectors.size() != m_vectors.size() ||
+			cursor.rotations.size() != m_rotations.size())
+			resetCursor(cursor);
+
+		for (size_t i = 0; i < m_floats.size(); i++)
+			floats[i] = m_floats[i].sample(time, cursor.floats[i]);
+
+		for (size_t i = 0; i < m_vectors.size(); i++)
+		{
+			Vector3D v = m_vectors[i].sample(time, cursor.vectors[i]);
+			vx[i] = v.x;
+			vy[i] = v.y;
+			vz[i] = v.z;
+		}
+
+		for (size_t i = 0; i < m_rotations.size(); i++)
+		{
+			Quaternion q = m_rotations[i].sample(time, cursor.rotations[i]);
+			qx[i] = q.x;
+			qy[i] = q.y;
+			qz[i] = q.z;
+			qw[i] = q.w;
+		}
+	}
+
+	std::vector<FloatCurve> m_floats;
+	std::vector<Vector3DCurve> m_vectors;
+	std::vector<QuaternionCurve> m_rotations;
+};
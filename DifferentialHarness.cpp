@@ -0,0 +1,516 @@
+#include "DifferentialHarness.h"
+#include "BatchKernels.h"
+#include "TransformBatch.h"
+#include "KernelGenerator.h"
+#include "StrictFloat.h"
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+ESGS_STRICT_FLOAT_BEGIN
+
+struct DifferentialInputs
+{
+    std::vector<float> ax, ay, az, bx, by, bz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> radius;
+    std::vector<float> scalars;
+    std::vector<Matrix4x4> ma, mb;
+    std::vector<Vector3D> translations, scales;
+    std::vector<Quaternion> rotations;
+    std::vector<Vector4D> planes;
+    Matrix4x4 transform;
+};
+
+static float adversarialFloat(uint32_t i)
+{
+    static const float values[] =
+    {
+        0.0f, -0.0f, 1e-40f, -1e-40f, FLT_MIN, 1e-20f, 1e30f, -1e30f,
+        NAN, INFINITY, -INFINITY, 1.0f, -1.0f, (float)epsilon * 0.5f
+    };
+    return values[i % (sizeof(values) / sizeof(values[0]))];
+}
+
+static Quaternion randomRotation(KernelRandom& random)
+{
+    Quaternion q(random.nextFloat(-1.0f, 1.0f), random.nextFloat(-1.0f, 1.0f), random.nextFloat(-1.0f, 1.0f), random.nextFloat(-1.0f, 1.0f));
+    float mag = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return mag > 1e-3f ? Quaternion(q.x / mag, q.y / mag, q.z / mag, q.w / mag) : Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static Matrix4x4 randomTransform(KernelRandom& random)
+{
+    Vector3D translation(random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f));
+    Vector3D scale(random.nextFloat(0.1f, 10.0f), random.nextFloat(0.1f, 10.0f), random.nextFloat(0.1f, 10.0f));
+    Matrix4x4 matrix;
+    TransformBatch::compose(translation, randomRotation(random), scale, matrix);
+    return matrix;
+}
+
+//Near-singular, degenerate, mirrored, sheared, NaN and huge transforms
+static Matrix4x4 adversarialTransform(KernelRandom& random, uint32_t kind)
+{
+    Matrix4x4 matrix = randomTransform(random);
+    switch (kind % 6)
+    {
+    case 0:
+        for (int c = 0; c < 3; c++)
+            matrix.m_mat[2][c] *= 1e-7f;
+        break;
+    case 1:
+        for (int c = 0; c < 3; c++)
+            matrix.m_mat[1][c] = 0.0f;
+        break;
+    case 2:
+        for (int c = 0; c < 3; c++)
+            matrix.m_mat[0][c] = -matrix.m_mat[0][c];
+        break;
+    case 3:
+        matrix.m_mat[1][0] += 0.5f * matrix.m_mat[0][0];
+        break;
+    case 4:
+        matrix.m_mat[random.next() % 4][random.next() % 4] = NAN;
+        break;
+    default:
+        matrix.m_mat[3][0] = 1e30f;
+        break;
+    }
+    return matrix;
+}
+
+static DifferentialInputs makeInputs(const DifferentialOptions& options)
+{
+    KernelRandom random(options.seed);
+    size_t count = options.count;
+    uint32_t threshold = (uint32_t)(options.adversarialRatio * 4294967295.0f);
+
+    DifferentialInputs in;
+    std::vector<float>* floats[] = { &in.ax, &in.ay, &in.az, &in.bx, &in.by, &in.bz, &in.qx, &in.qy, &in.qz, &in.qw, &in.scalars };
+    for (std::vector<float>* values : floats)
+    {
+        values->resize(count);
+        for (size_t i = 0; i < count; i++)
+            (*values)[i] = random.next() < threshold ? adversarialFloat(random.next()) : random.nextFloat(-2.0f, 2.0f);
+    }
+
+    //Antipodal pairs, q and -q must normalize to opposite quaternions
+    for (size_t i = 1; i < count; i += 2)
+    {
+        if (random.next() < threshold)
+        {
+            in.qx[i] = -in.qx[i - 1];
+            in.qy[i] = -in.qy[i - 1];
+            in.qz[i] = -in.qz[i - 1];
+            in.qw[i] = -in.qw[i - 1];
+        }
+    }
+
+    in.radius.resize(count);
+    for (size_t i = 0; i < count; i++)
+        in.radius[i] = random.next() < threshold ? fabsf(adversarialFloat(random.next())) : random.nextFloat(0.0f, 1.0f);
+
+    in.ma.resize(count);
+    in.mb.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        in.ma[i] = random.next() < threshold ? adversarialTransform(random, random.next()) : randomTransform(random);
+        in.mb[i] = random.next() < threshold ? adversarialTransform(random, random.next()) : randomTransform(random);
+    }
+
+    in.translations.resize(count);
+    in.scales.resize(count);
+    in.rotations.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        in.translations[i] = Vector3D(random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f));
+        in.scales[i] = Vector3D(random.nextFloat(-10.0f, 10.0f), random.nextFloat(-10.0f, 10.0f), random.nextFloat(-10.0f, 10.0f));
+        in.rotations[i] = randomRotation(random);
+        if (random.next() < threshold)
+        {
+            Quaternion& q = in.rotations[i];
+            switch (random.next() % 3)
+            {
+            case 0:
+                if (i > 0)
+                    q = Quaternion(-in.rotations[i - 1].x, -in.rotations[i - 1].y, -in.rotations[i - 1].z, -in.rotations[i - 1].w);
+                break;
+            case 1:
+                q = Quaternion(q.x * 3.0f, q.y * 3.0f, q.z * 3.0f, q.w * 3.0f);
+                break;
+            default:
+                q.x = NAN;
+                break;
+            }
+        }
+    }
+
+    //Unit cube frustum, normals pointing inside
+    in.planes.push_back(Vector4D(1.0f, 0.0f, 0.0f, 1.0f));
+    in.planes.push_back(Vector4D(-1.0f, 0.0f, 0.0f, 1.0f));
+    in.planes.push_back(Vector4D(0.0f, 1.0f, 0.0f, 1.0f));
+    in.planes.push_back(Vector4D(0.0f, -1.0f, 0.0f, 1.0f));
+    in.planes.push_back(Vector4D(0.0f, 0.0f, 1.0f, 1.0f));
+    in.planes.push_back(Vector4D(0.0f, 0.0f, -1.0f, 1.0f));
+
+    in.transform = randomTransform(random);
+    return in;
+}
+
+//Fastest of the runs, prepare is not timed
+template<typename P, typename T>
+static double measure(uint32_t repetitions, P prepare, T body)
+{
+    double best = 0.0;
+    for (uint32_t r = 0; r < (repetitions ? repetitions : 1); r++)
+    {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+template<typename T>
+static double measure(uint32_t repetitions, T body)
+{
+    return measure(repetitions, [] {}, body);
+}
+
+template<typename T>
+static void compareIntegers(const T* reference, const T* fast, size_t count, DifferentialResult& result)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t diff = reference[i] > fast[i] ? (uint64_t)(reference[i] - fast[i]) : (uint64_t)(fast[i] - reference[i]);
+        if (diff > result.maxUlp)
+        {
+            result.maxUlp = diff;
+            result.maxAbsError = (double)diff;
+            result.worstIndex = result.outputs + i;
+        }
+    }
+    result.outputs += count;
+}
+
+static void finish(DifferentialResult& result, double referenceNanoseconds, double fastNanoseconds)
+{
+    result.referenceNanoseconds = referenceNanoseconds;
+    result.fastNanoseconds = fastNanoseconds;
+    result.speedup = fastNanoseconds > 0.0 ? referenceNanoseconds / fastNanoseconds : 0.0;
+}
+
+uint64_t DifferentialHarness::ulpDistance(float a, float b)
+{
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(float));
+    memcpy(&ib, &b, sizeof(float));
+    int64_t oa = ia < 0 ? -(int64_t)(ia & 0x7FFFFFFF) : (int64_t)ia;
+    int64_t ob = ib < 0 ? -(int64_t)(ib & 0x7FFFFFFF) : (int64_t)ib;
+    return (uint64_t)(oa > ob ? oa - ob : ob - oa);
+}
+
+void DifferentialHarness::compare(const float* reference, const float* fast, size_t count, DifferentialResult& result)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float r = reference[i];
+        float f = fast[i];
+        if (std::isnan(r) || std::isnan(f))
+        {
+            if (!(std::isnan(r) && std::isnan(f)))
+                result.mismatches++;
+            continue;
+        }
+        if (std::isinf(r) || std::isinf(f))
+        {
+            if (r != f)
+                result.mismatches++;
+            continue;
+        }
+
+        uint64_t ulp = ulpDistance(r, f);
+        double error = fabs((double)r - (double)f);
+        if (ulp > result.maxUlp)
+        {
+            result.maxUlp = ulp;
+            result.worstIndex = result.outputs + i;
+        }
+        if (error > result.maxAbsError)
+            result.maxAbsError = error;
+    }
+    result.outputs += count;
+}
+
+DifferentialHarness::DifferentialHarness(const DifferentialOptions& options) : m_options(options)
+{
+}
+
+DifferentialReport DifferentialHarness::run(SimdLevel level) const
+{
+    DifferentialInputs in = makeInputs(m_options);
+    BatchKernelTable fast = BatchKernels::create(level);
+    BatchKernelTable scalar = BatchKernels::create(SimdLevel::Scalar);
+    size_t n = m_options.count;
+    uint32_t reps = m_options.repetitions;
+
+    DifferentialReport report;
+    auto begin = [&](const char* kernel) -> DifferentialResult&
+    {
+        report.results.push_back(DifferentialResult());
+        report.results.back().kernel = kernel;
+        report.results.back().level = fast.level;
+        return report.results.back();
+    };
+
+    std::vector<float> rx(n), ry(n), rz(n), rw(n), fx(n), fy(n), fz(n), fw(n);
+
+    {
+        DifferentialResult& result = begin("normalize3");
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                Vector3D v(in.ax[i], in.ay[i], in.az[i]);
+                v.normalize();
+                rx[i] = v.x;
+                ry[i] = v.y;
+                rz[i] = v.z;
+            }
+        });
+        double fastTime = measure(reps, [&] { fx = in.ax; fy = in.ay; fz = in.az; },
+            [&] { fast.normalize3(fx.data(), fy.data(), fz.data(), n); });
+        compare(rx.data(), fx.data(), n, result);
+        compare(ry.data(), fy.data(), n, result);
+        compare(rz.data(), fz.data(), n, result);
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("dot3");
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                Vector3D a(in.ax[i], in.ay[i], in.az[i]);
+                Vector3D b(in.bx[i], in.by[i], in.bz[i]);
+                rx[i] = a.dot(b);
+            }
+        });
+        double fastTime = measure(reps, [&]
+        {
+            fast.dot3(in.ax.data(), in.ay.data(), in.az.data(), in.bx.data(), in.by.data(), in.bz.data(), fx.data(), n);
+        });
+        compare(rx.data(), fx.data(), n, result);
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("transformPoints");
+        const float (*m)[4] = in.transform.m_mat;
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                float x = in.ax[i], y = in.ay[i], z = in.az[i];
+                rx[i] = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+                ry[i] = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+                rz[i] = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+            }
+        });
+        double fastTime = measure(reps, [&]
+        {
+            fast.transformPoints(in.transform, in.ax.data(), in.ay.data(), in.az.data(), fx.data(), fy.data(), fz.data(), n);
+        });
+        compare(rx.data(), fx.data(), n, result);
+        compare(ry.data(), fy.data(), n, result);
+        compare(rz.data(), fz.data(), n, result);
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("multiplyMatrices");
+        std::vector<Matrix4x4> reference(n), out(n);
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                reference[i] = in.ma[i];
+                reference[i] *= in.mb[i];
+            }
+        });
+        double fastTime = measure(reps, [&] { fast.multiplyMatrices(in.ma.data(), in.mb.data(), out.data(), n); });
+        compare(&reference[0].m_mat[0][0], &out[0].m_mat[0][0], n * 16, result);
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("normalizeQuaternions");
+        double refTime = measure(reps, [&]
+        {
+            Quaternion helper;
+            for (size_t i = 0; i < n; i++)
+            {
+                Quaternion q = helper.normalizeSafe(Quaternion(in.qx[i], in.qy[i], in.qz[i], in.qw[i]));
+                rx[i] = q.x;
+                ry[i] = q.y;
+                rz[i] = q.z;
+                rw[i] = q.w;
+            }
+        });
+        double fastTime = measure(reps, [&] { fx = in.qx; fy = in.qy; fz = in.qz; fw = in.qw; },
+            [&] { fast.normalizeQuaternions(fx.data(), fy.data(), fz.data(), fw.data(), n); });
+        compare(rx.data(), fx.data(), n, result);
+        compare(ry.data(), fy.data(), n, result);
+        compare(rz.data(), fz.data(), n, result);
+        compare(rw.data(), fw.data(), n, result);
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("decomposeTransforms");
+        std::vector<Vector3D> refT(n), refS(n), outT(n), outS(n);
+        std::vector<Quaternion> refR(n), outR(n);
+        std::vector<uint8_t> refShear(n), outShear(n);
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+                refShear[i] = TransformBatch::decompose(in.ma[i], refT[i], refR[i], refS[i]) ? 1 : 0;
+        });
+        double fastTime = measure(reps, [&] { fast.decomposeTransforms(in.ma.data(), n, outT.data(), outR.data(), outS.data(), outShear.data()); });
+        compare(&refT[0].x, &outT[0].x, n * 3, result);
+        compare(&refR[0].x, &outR[0].x, n * 4, result);
+        compare(&refS[0].x, &outS[0].x, n * 3, result);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (refShear[i] != outShear[i])
+                result.mismatches++;
+        }
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("composeTransforms");
+        std::vector<Matrix4x4> reference(n), out(n);
+        double refTime = measure(reps, [&]
+        {
+            for (size_t i = 0; i < n; i++)
+                TransformBatch::compose(in.translations[i], in.rotations[i], in.scales[i], reference[i]);
+        });
+        double fastTime = measure(reps, [&] { fast.composeTransforms(in.translations.data(), in.rotations.data(), in.scales.data(), n, out.data()); });
+        compare(&reference[0].m_mat[0][0], &out[0].m_mat[0][0], n * 16, result);
+        finish(result, refTime, fastTime);
+    }
+
+    //No member function equivalents, the scalar table is the reference
+    {
+        DifferentialResult& result = begin("cullSpheres");
+        std::vector<uint8_t> reference(n), out(n);
+        double refTime = measure(reps, [&]
+        {
+            scalar.cullSpheres(in.planes.data(), in.planes.size(), in.ax.data(), in.ay.data(), in.az.data(), in.radius.data(), reference.data(), n);
+        });
+        double fastTime = measure(reps, [&]
+        {
+            fast.cullSpheres(in.planes.data(), in.planes.size(), in.ax.data(), in.ay.data(), in.az.data(), in.radius.data(), out.data(), n);
+        });
+        for (size_t i = 0; i < n; i++)
+        {
+            if (reference[i] != out[i])
+                result.mismatches++;
+        }
+        result.outputs = n;
+        finish(result, refTime, fastTime);
+    }
+
+    {
+        DifferentialResult& result = begin("encodeSnorm16");
+        std::vector<int16_t> reference(n), out(n);
+        double refTime = measure(reps, [&] { scalar.encodeSnorm16(in.scalars.data(), reference.data(), n); });
+        double fastTime = measure(reps, [&] { fast.encodeSnorm16(in.scalars.data(), out.data(), n); });
+        compareIntegers(reference.data(), out.data(), n, result);
+        finish(result, refTime, fastTime);
+    }
+
+    //Which sample points take the scalar tail depends on the thread count, so the SSE and
+    //scalar mappings of KernelGenerator must agree bit for bit, signed zeros included
+    if (fast.level == SimdLevel::SSE2)
+    {
+        DifferentialResult& result = begin("mapSamples");
+        KernelRandom random(m_options.seed);
+        std::vector<float> u(n), v(n), reference(n * 3), out(n * 3);
+        for (size_t i = 0; i < n; i++)
+        {
+            u[i] = random.nextFloat();
+            //Exact fractions land on the branch points of the angle reduction
+            v[i] = i % 2 ? random.nextFloat() : float(i) / float(n);
+        }
+
+        double refTime = 0.0, fastTime = 0.0;
+        for (int domain = (int)SampleDomain::Square; domain <= (int)SampleDomain::Sphere; domain++)
+        {
+            refTime += measure(reps, [&]
+            {
+                KernelGenerator::mapSamples((SampleDomain)domain, u.data(), v.data(), &reference[0], &reference[n], &reference[n * 2], n, false);
+            });
+            fastTime += measure(reps, [&]
+            {
+                KernelGenerator::mapSamples((SampleDomain)domain, u.data(), v.data(), &out[0], &out[n], &out[n * 2], n, true);
+            });
+
+            for (size_t i = 0; i < n * 3; i++)
+            {
+                if (memcmp(&reference[i], &out[i], sizeof(float)) != 0 && result.mismatches++ == 0)
+                    result.worstIndex = result.outputs + i;
+            }
+            compare(reference.data(), out.data(), n * 3, result);
+        }
+        finish(result, refTime, fastTime);
+    }
+
+    return report;
+}
+
+DifferentialReport DifferentialHarness::runAll() const
+{
+    DifferentialReport report;
+    for (int level = (int)SimdLevel::Scalar; level <= (int)CpuFeatures::getSupportedLevel(); level++)
+    {
+        DifferentialReport levelReport = run((SimdLevel)level);
+        report.results.insert(report.results.end(), levelReport.results.begin(), levelReport.results.end());
+    }
+    return report;
+}
+
+bool DifferentialReport::passes(uint64_t maxUlp, double maxAbsError) const
+{
+    for (const DifferentialResult& result : results)
+    {
+        if (result.mismatches > 0)
+            return false;
+        if (result.maxUlp > maxUlp && result.maxAbsError > maxAbsError)
+            return false;
+    }
+    return true;
+}
+
+std::string DifferentialReport::toCsv() const
+{
+    std::string out = "kernel,level,outputs,maxUlp,maxAbsError,worstIndex,mismatches,referenceNs,fastNs,speedup\n";
+    char line[256];
+    for (const DifferentialResult& r : results)
+    {
+        snprintf(line, sizeof(line), "%s,%s,%llu,%llu,%g,%llu,%llu,%.0f,%.0f,%.2f\n", r.kernel, CpuFeatures::getLevelName(r.level),
+            (unsigned long long)r.outputs, (unsigned long long)r.maxUlp, r.maxAbsError, (unsigned long long)r.worstIndex,
+            (unsigned long long)r.mismatches, r.referenceNanoseconds, r.fastNanoseconds, r.speedup);
+        out += line;
+    }
+    return out;
+}
+
+ESGS_STRICT_FLOAT_END
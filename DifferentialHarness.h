@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuFeatures.h"
+#include "Export.h"
+
+struct DifferentialOptions
+{
+	size_t count = 4096;
+	uint32_t seed = 1;
+	//Timings keep the fastest of these runs
+	uint32_t repetitions = 8;
+	//Share of inputs replaced by denormals, NaN, infinities, zero and huge values,
+	//near-singular matrices and antipodal quaternions
+	float adversarialRatio = 0.125f;
+};
+
+struct DifferentialResult
+{
+	const char* kernel = "";
+	SimdLevel level = SimdLevel::Scalar;
+	size_t outputs = 0;
+	//Between finite outputs, integer outputs report their difference in both
+	uint64_t maxUlp = 0;
+	double maxAbsError = 0.0;
+	size_t worstIndex = 0;
+	//Outputs that are NaN on only one side or whose flags differ, for mapSamples any
+	//output whose bits differ
+	size_t mismatches = 0;
+	double referenceNanoseconds = 0.0;
+	double fastNanoseconds = 0.0;
+	double speedup = 0.0;
+};
+
+struct ESGS_EXPORT DifferentialReport
+{
+	std::vector<DifferentialResult> results;
+
+	//Every result within maxUlp or maxAbsError and without mismatches
+	bool passes(uint64_t maxUlp, double maxAbsError) const;
+	std::string toCsv() const;
+};
+
+//Runs the fast paths (BatchKernels at each SIMD level, TransformBatch SSE, the sample
+//mapping of KernelGenerator) against the scalar functions they replace on the same
+//randomized and adversarial inputs.
+class ESGS_EXPORT DifferentialHarness
+{
+public:
+	DifferentialHarness(const DifferentialOptions& options = DifferentialOptions());
+
+	//Kernels of BatchKernels::create(level), level is capped to what the CPU supports
+	DifferentialReport run(SimdLevel level) const;
+	//Every supported level from Scalar up
+	DifferentialReport runAll() const;
+
+	//Distance in representable floats, 0 for equal values including +0/-0
+	static uint64_t ulpDistance(float a, float b);
+	//Accumulates into result, for fast paths outside the batch table
+	static void compare(const float* reference, const float* fast, size_t count, DifferentialResult& result);
+
+private:
+	DifferentialOptions m_options;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Matrix4x4.h"
+#include "Export.h"
+
+static_assert(sizeof(Vector2D) == sizeof(DirectX::XMFLOAT2), "Vector2D layout must match XMFLOAT2");
+static_assert(sizeof(Vector3D) == sizeof(DirectX::XMFLOAT3), "Vector3D layout must match XMFLOAT3");
+static_assert(sizeof(Vector4D) == sizeof(DirectX::XMFLOAT4), "Vector4D layout must match XMFLOAT4");
+static_assert(sizeof(Matrix4x4) == sizeof(DirectX::XMFLOAT4X4), "Matrix4x4 layout must match XMFLOAT4X4");
+
+//DirectX adapter for the math kit, the core headers do not include DirectXMath.
+//Both use row vectors, so Matrix4x4 and XMFLOAT4X4 share rows as well as bytes.
+class ESGS_EXPORT DirectXInterop
+{
+public:
+	static DirectX::XMFLOAT2* view(Vector2D* data) { return reinterpret_cast<DirectX::XMFLOAT2*>(data); }
+	static const DirectX::XMFLOAT2* view(const Vector2D* data) { return reinterpret_cast<const DirectX::XMFLOAT2*>(data); }
+	static DirectX::XMFLOAT3* view(Vector3D* data) { return reinterpret_cast<DirectX::XMFLOAT3*>(data); }
+	static const DirectX::XMFLOAT3* view(const Vector3D* data) { return reinterpret_cast<const DirectX::XMFLOAT3*>(data); }
+	static DirectX::XMFLOAT4* view(Vector4D* data) { return reinterpret_cast<DirectX::XMFLOAT4*>(data); }
+	static const DirectX::XMFLOAT4* view(const Vector4D* data) { return reinterpret_cast<const DirectX::XMFLOAT4*>(data); }
+	static DirectX::XMFLOAT4X4* view(Matrix4x4* data) { return reinterpret_cast<DirectX::XMFLOAT4X4*>(data); }
+	static const DirectX::XMFLOAT4X4* view(const Matrix4x4* data) { return reinterpret_cast<const DirectX::XMFLOAT4X4*>(data); }
+
+	static DirectX::XMVECTOR load(const Vector3D& v) { return DirectX::XMLoadFloat3(view(&v)); }
+	static DirectX::XMVECTOR load(const Vector4D& v) { return DirectX::XMLoadFloat4(view(&v)); }
+	static DirectX::XMMATRIX load(const Matrix4x4& m) { return DirectX::XMLoadFloat4x4(view(&m)); }
+
+	static Vector3D storeVector3D(DirectX::FXMVECTOR v)
+	{
+		Vector3D out;
+		DirectX::XMStoreFloat3(view(&out), v);
+		return out;
+	}
+
+	static Vector4D storeVector4D(DirectX::FXMVECTOR v)
+	{
+		Vector4D out;
+		DirectX::XMStoreFloat4(view(&out), v);
+		return out;
+	}
+
+	static Matrix4x4 storeMatrix4x4(DirectX::FXMMATRIX m)
+	{
+		Matrix4x4 out;
+		DirectX::XMStoreFloat4x4(view(&out), m);
+		return out;
+	}
+};
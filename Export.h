@@ -0,0 +1,12 @@
+#pragma once
+
+//Engine builds provide ESGS_EXPORT through DLL.h, standalone builds export nothing
+#if defined(__has_include)
+#if __has_include("DLL.h")
+#include "DLL.h"
+#endif
+#endif
+
+#ifndef ESGS_EXPORT
+#define ESGS_EXPORT
+#endif
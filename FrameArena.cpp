@@ -0,0 +1,123 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t capacity)
+{
+    addBlock(capacity ? capacity : ESGS_ARENA_ALIGNMENT);
+}
+
+FrameArena::~FrameArena()
+{
+    releaseBlocks();
+}
+
+void FrameArena::addBlock(size_t size)
+{
+    size = (size + ESGS_ARENA_ALIGNMENT - 1) & ~(size_t)(ESGS_ARENA_ALIGNMENT - 1);
+    Block block;
+    block.data = static_cast<char*>(::operator new(size, std::align_val_t(ESGS_ARENA_ALIGNMENT)));
+    block.size = size;
+    block.used = 0;
+    m_blocks.push_back(block);
+}
+
+void FrameArena::releaseBlocks()
+{
+    for (Block& block : m_blocks)
+        ::operator delete(block.data, std::align_val_t(ESGS_ARENA_ALIGNMENT));
+    m_blocks.clear();
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    while (true)
+    {
+        Block& block = m_blocks[m_current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        uintptr_t start = (base + block.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (start + bytes <= base + block.size)
+        {
+            block.used = start + bytes - base;
+            size_t used = getUsed();
+            if (used > m_peak)
+                m_peak = used;
+            return reinterpret_cast<void*>(start);
+        }
+
+        //Blocks kept after a rewind are reused before growing
+        if (m_current + 1 < m_blocks.size())
+        {
+            m_current++;
+            m_blocks[m_current].used = 0;
+            if (m_blocks[m_current].size >= bytes + alignment)
+                continue;
+
+            //Too small for this request, drop it and everything after it
+            for (size_t i = m_current; i < m_blocks.size(); i++)
+                ::operator delete(m_blocks[i].data, std::align_val_t(ESGS_ARENA_ALIGNMENT));
+            m_blocks.erase(m_blocks.begin() + m_current, m_blocks.end());
+        }
+
+        size_t size = m_blocks.back().size * 2;
+        if (size < bytes + alignment)
+            size = bytes + alignment;
+        addBlock(size);
+        m_current = m_blocks.size() - 1;
+    }
+}
+
+FrameArenaMarker FrameArena::getMarker() const
+{
+    FrameArenaMarker marker;
+    marker.block = m_current;
+    marker.used = m_blocks[m_current].used;
+    return marker;
+}
+
+void FrameArena::rewind(const FrameArenaMarker& marker)
+{
+    m_current = marker.block;
+    m_blocks[m_current].used = marker.used;
+}
+
+void FrameArena::reset()
+{
+    //Merge overflow into one block that holds the whole peak frame
+    if (m_blocks.size() > 1)
+    {
+        size_t total = 0;
+        for (const Block& block : m_blocks)
+            total += block.size;
+        releaseBlocks();
+        addBlock(total > m_peak ? total : m_peak);
+    }
+
+    m_current = 0;
+    m_blocks[0].used = 0;
+}
+
+size_t FrameArena::getUsed() const
+{
+    size_t used = 0;
+    for (size_t i = 0; i < m_current; i++)
+        used += m_blocks[i].size;
+    return used + m_blocks[m_current].used;
+}
+
+size_t FrameArena::getCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : m_blocks)
+        capacity += block.size;
+    return capacity;
+}
+
+size_t FrameArena::getPeak() const
+{
+    return m_peak;
+}
+
+FrameArena& FrameArena::getThreadArena()
+{
+    static thread_local FrameArena arena;
+    return arena;
+}
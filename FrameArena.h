@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "Export.h"
+
+#ifndef ESGS_FRAME_ARENA_SIZE
+#define ESGS_FRAME_ARENA_SIZE (1u << 20)
+#endif // !ESGS_FRAME_ARENA_SIZE
+
+//Cache line, also covers a full AVX-512 register
+#ifndef ESGS_ARENA_ALIGNMENT
+#define ESGS_ARENA_ALIGNMENT 64
+#endif // !ESGS_ARENA_ALIGNMENT
+
+struct FrameArenaMarker
+{
+	size_t block = 0;
+	size_t used = 0;
+};
+
+//Linear allocator for transient per-frame buffers. Allocation bumps an offset and
+//nothing is freed individually; reset() releases everything at once. When a frame
+//needs more than the capacity, overflow blocks are chained and merged into a single
+//block on the next reset, so once the peak is reached frames stop touching the heap.
+//Not thread safe, use one arena per thread (getThreadArena) or allocate up front and
+//hand the ranges to workers.
+class ESGS_EXPORT FrameArena
+{
+public:
+	FrameArena(size_t capacity = ESGS_FRAME_ARENA_SIZE);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator =(const FrameArena&) = delete;
+
+	//alignment must be a power of two
+	void* allocate(size_t bytes, size_t alignment = ESGS_ARENA_ALIGNMENT);
+
+	//Uninitialized storage, the size is rounded up to whole alignment units so
+	//vector loops may load and store the padding past count
+	template<typename T>
+	T* allocate(size_t count, size_t alignment = ESGS_ARENA_ALIGNMENT)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+		if (alignment < alignof(T))
+			alignment = alignof(T);
+		size_t bytes = (count * sizeof(T) + alignment - 1) & ~(alignment - 1);
+		return static_cast<T*>(allocate(bytes, alignment));
+	}
+
+	//Scoped scratch inside a frame: everything allocated after getMarker() is released by rewind()
+	FrameArenaMarker getMarker() const;
+	void rewind(const FrameArenaMarker& marker);
+
+	//Start of frame, invalidates every pointer handed out
+	void reset();
+
+	size_t getUsed() const;
+	size_t getCapacity() const;
+	//Highest getUsed() seen since construction
+	size_t getPeak() const;
+
+	//Arena of the calling thread, created with ESGS_FRAME_ARENA_SIZE on first use
+	static FrameArena& getThreadArena();
+
+private:
+	struct Block
+	{
+		char* data;
+		size_t size;
+		size_t used;
+	};
+
+	void addBlock(size_t size);
+	void releaseBlocks();
+
+	std::vector<Block> m_blocks;
+	size_t m_current = 0;
+	size_t m_peak = 0;
+};
+
+//Rewinds to the position at construction
+class FrameArenaScope
+{
+public:
+	FrameArenaScope(FrameArena& arena) : m_arena(arena), m_marker(arena.getMarker())
+	{
+	}
+
+	~FrameArenaScope()
+	{
+		m_arena.rewind(m_marker);
+	}
+
+	FrameArenaScope(const FrameArenaScope&) = delete;
+	FrameArenaScope& operator =(const FrameArenaScope&) = delete;
+
+private:
+	FrameArena& m_arena;
+	FrameArenaMarker m_marker;
+};
+
+//Standard allocator over a FrameArena for containers that live within one frame,
+//deallocate is a no-op
+template<typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena)
+	{
+	}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.getArena())
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16));
+	}
+
+	void deallocate(T*, size_t) noexcept
+	{
+	}
+
+	FrameArena* getArena() const noexcept
+	{
+		return m_arena;
+	}
+
+	template<typename U>
+	bool operator ==(const ArenaAllocator<U>& other) const noexcept
+	{
+		return m_arena == other.getArena();
+	}
+
+	template<typename U>
+	bool operator !=(const ArenaAllocator<U>& other) const noexcept
+	{
+		return m_arena != other.getArena();
+	}
+
+private:
+	FrameArena* m_arena;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
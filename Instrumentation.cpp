@@ -0,0 +1,216 @@
+#include "Instrumentation.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+static const char* counterNames[(int)ProfileCounter::Count] =
+{
+    "MatrixMultiply",
+    "MatrixInverse",
+    "QuaternionSlerp",
+    "VectorNormalize",
+    "KernelGeneration",
+    "BatchVector",
+    "BatchMatrix",
+    "BatchQuaternion",
+    "BatchTransform",
+    "BatchCulling",
+    "BatchEncoding",
+    "NoiseSample"
+};
+
+const char* Instrumentation::getName(ProfileCounter counter)
+{
+    int i = (int)counter;
+    return i >= 0 && i < (int)ProfileCounter::Count ? counterNames[i] : "Unknown";
+}
+
+static ProfileSnapshot emptySnapshot()
+{
+    ProfileSnapshot snapshot;
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+        snapshot.counters[i].name = counterNames[i];
+    return snapshot;
+}
+
+#ifdef ESGS_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+
+//Counters of one thread, written only by that thread and read by snapshot()
+struct ProfileThreadCounters
+{
+    ProfileThreadCounters();
+    ~ProfileThreadCounters();
+
+    std::atomic<uint64_t> calls[(int)ProfileCounter::Count];
+    std::atomic<uint64_t> elements[(int)ProfileCounter::Count];
+    std::atomic<uint64_t> nanoseconds[(int)ProfileCounter::Count];
+};
+
+static ProfileThreadCounters& profileThreadCounters()
+{
+    static thread_local ProfileThreadCounters counters;
+    return counters;
+}
+
+void profile_counters::count(ProfileCounter counter, uint64_t elements)
+{
+    ProfileThreadCounters& t = profileThreadCounters();
+    int i = (int)counter;
+    t.calls[i].store(t.calls[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    t.elements[i].store(t.elements[i].load(std::memory_order_relaxed) + elements, std::memory_order_relaxed);
+}
+
+void profile_counters::addTime(ProfileCounter counter, uint64_t nanoseconds)
+{
+    ProfileThreadCounters& t = profileThreadCounters();
+    int i = (int)counter;
+    t.nanoseconds[i].store(t.nanoseconds[i].load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+}
+
+uint64_t profile_counters::now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Instrumentation::count(ProfileCounter counter, uint64_t elements)
+{
+    profile_counters::count(counter, elements);
+}
+
+void Instrumentation::addTime(ProfileCounter counter, uint64_t nanoseconds)
+{
+    profile_counters::addTime(counter, nanoseconds);
+}
+
+//Live threads plus totals of exited threads and the reset baseline
+struct ProfileRegistry
+{
+    std::mutex mutex;
+    std::vector<ProfileThreadCounters*> threads;
+    ProfileSnapshot retired = emptySnapshot();
+    ProfileSnapshot baseline = emptySnapshot();
+};
+
+static ProfileRegistry& profileRegistry()
+{
+    static ProfileRegistry registry;
+    return registry;
+}
+
+ProfileThreadCounters::ProfileThreadCounters()
+{
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+    {
+        calls[i].store(0, std::memory_order_relaxed);
+        elements[i].store(0, std::memory_order_relaxed);
+        nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+
+    ProfileRegistry& registry = profileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+ProfileThreadCounters::~ProfileThreadCounters()
+{
+    ProfileRegistry& registry = profileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+    {
+        registry.retired.counters[i].calls += calls[i].load(std::memory_order_relaxed);
+        registry.retired.counters[i].elements += elements[i].load(std::memory_order_relaxed);
+        registry.retired.counters[i].nanoseconds += nanoseconds[i].load(std::memory_order_relaxed);
+    }
+    registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), this), registry.threads.end());
+}
+
+static ProfileSnapshot totals(ProfileRegistry& registry)
+{
+    ProfileSnapshot sum = registry.retired;
+    for (ProfileThreadCounters* t : registry.threads)
+    {
+        for (int i = 0; i < (int)ProfileCounter::Count; i++)
+        {
+            sum.counters[i].calls += t->calls[i].load(std::memory_order_relaxed);
+            sum.counters[i].elements += t->elements[i].load(std::memory_order_relaxed);
+            sum.counters[i].nanoseconds += t->nanoseconds[i].load(std::memory_order_relaxed);
+        }
+    }
+    return sum;
+}
+
+ProfileSnapshot Instrumentation::snapshot()
+{
+    ProfileRegistry& registry = profileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    ProfileSnapshot sum = totals(registry);
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+    {
+        sum.counters[i].calls -= registry.baseline.counters[i].calls;
+        sum.counters[i].elements -= registry.baseline.counters[i].elements;
+        sum.counters[i].nanoseconds -= registry.baseline.counters[i].nanoseconds;
+    }
+    return sum;
+}
+
+void Instrumentation::reset()
+{
+    ProfileRegistry& registry = profileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.baseline = totals(registry);
+}
+
+#else
+
+void Instrumentation::count(ProfileCounter, uint64_t)
+{
+}
+
+void Instrumentation::addTime(ProfileCounter, uint64_t)
+{
+}
+
+ProfileSnapshot Instrumentation::snapshot()
+{
+    return emptySnapshot();
+}
+
+void Instrumentation::reset()
+{
+}
+
+#endif
+
+std::string ProfileSnapshot::toCsv() const
+{
+    std::string out = "name,calls,elements,nanoseconds\n";
+    char line[160];
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+    {
+        const ProfileCounterSample& c = counters[i];
+        snprintf(line, sizeof(line), "%s,%llu,%llu,%llu\n", c.name,
+            (unsigned long long)c.calls, (unsigned long long)c.elements, (unsigned long long)c.nanoseconds);
+        out += line;
+    }
+    return out;
+}
+
+std::string ProfileSnapshot::toJson() const
+{
+    std::string out = "[";
+    char line[200];
+    for (int i = 0; i < (int)ProfileCounter::Count; i++)
+    {
+        const ProfileCounterSample& c = counters[i];
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"calls\":%llu,\"elements\":%llu,\"nanoseconds\":%llu}",
+            i ? "," : "", c.name, (unsigned long long)c.calls, (unsigned long long)c.elements, (unsigned long long)c.nanoseconds);
+        out += line;
+    }
+    out += "]";
+    return out;
+}
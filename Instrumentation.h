@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "ProfileCounters.h"
+#include "Export.h"
+
+struct ProfileCounterSample
+{
+	const char* name = "";
+	uint64_t calls = 0;
+	uint64_t elements = 0;
+	uint64_t nanoseconds = 0;
+};
+
+struct ESGS_EXPORT ProfileSnapshot
+{
+	ProfileCounterSample counters[(int)ProfileCounter::Count];
+
+	//name,calls,elements,nanoseconds with a header row
+	std::string toCsv() const;
+	//[{"name":...,"calls":...,"elements":...,"nanoseconds":...}, ...]
+	std::string toJson() const;
+};
+
+//Reporting side of the counters declared in ProfileCounters.h
+class ESGS_EXPORT Instrumentation
+{
+public:
+	static constexpr bool isEnabled()
+	{
+#ifdef ESGS_INSTRUMENTATION
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	static void count(ProfileCounter counter, uint64_t elements);
+	static void addTime(ProfileCounter counter, uint64_t nanoseconds);
+
+	//Totals of all threads since the last reset, threads that exited included
+	static ProfileSnapshot snapshot();
+	//Sets the baseline for later snapshots, counting threads are not disturbed
+	static void reset();
+
+	static const char* getName(ProfileCounter counter);
+};
@@ -0,0 +1,369 @@
+#include "KdTree.h"
+#include "AsyncCore.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//Ranges of at most this many points are not split
+#define KDTREE_LEAF_SIZE 8
+//Queries per task for batched queries
+#define KDTREE_QUERY_CHUNK 256
+//Traversal stack, the tree is balanced so depth is about 2 * log2(count)
+#define KDTREE_STACK_SIZE 128
+
+struct KdTreeEntry
+{
+    float p[3];
+    uint32_t index;
+};
+
+struct KdTreeRange
+{
+    uint32_t begin;
+    uint32_t end;
+};
+
+struct KdTreeStackEntry
+{
+    uint32_t begin;
+    uint32_t end;
+    float distanceSq;
+};
+
+template<typename T>
+static void run(size_t count, size_t chunk, bool parallel, T body)
+{
+    if (parallel)
+        __parallel_for(count, chunk, body);
+    else
+        body((size_t)0, count);
+}
+
+void KdTree::build(const Vector3D* points, size_t count, bool parallel)
+{
+    std::vector<KdTreeEntry> entries(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        entries[i].p[0] = points[i].x;
+        entries[i].p[1] = points[i].y;
+        entries[i].p[2] = points[i].z;
+        entries[i].index = (uint32_t)i;
+    }
+    m_axes.assign(count, 0);
+
+    //One level at a time, the ranges of a level are disjoint and split in parallel
+    std::vector<KdTreeRange> level(1, KdTreeRange{ 0, (uint32_t)count });
+    std::vector<KdTreeRange> next;
+    KdTreeEntry* data = entries.data();
+    uint8_t* axes = m_axes.data();
+    while (!level.empty())
+    {
+        next.assign(level.size() * 2, KdTreeRange{ 0, 0 });
+        const KdTreeRange* ranges = level.data();
+        KdTreeRange* children = next.data();
+        run(level.size(), 1, parallel && level.size() > 1, [=](size_t begin, size_t end)
+        {
+            for (size_t r = begin; r < end; r++)
+            {
+                uint32_t b = ranges[r].begin, e = ranges[r].end;
+                if (e - b <= KDTREE_LEAF_SIZE)
+                    continue;
+
+                float lo[3] = { data[b].p[0], data[b].p[1], data[b].p[2] };
+                float hi[3] = { lo[0], lo[1], lo[2] };
+                for (uint32_t i = b + 1; i < e; i++)
+                {
+                    for (int a = 0; a < 3; a++)
+                    {
+                        lo[a] = std::min(lo[a], data[i].p[a]);
+                        hi[a] = std::max(hi[a], data[i].p[a]);
+                    }
+                }
+                int axis = 0;
+                if (hi[1] - lo[1] > hi[axis] - lo[axis])
+                    axis = 1;
+                if (hi[2] - lo[2] > hi[axis] - lo[axis])
+                    axis = 2;
+
+                uint32_t mid = (b + e) / 2;
+                std::nth_element(data + b, data + mid, data + e, [axis](const KdTreeEntry& l, const KdTreeEntry& r)
+                {
+                    return l.p[axis] < r.p[axis];
+                });
+                axes[mid] = (uint8_t)axis;
+                children[r * 2] = KdTreeRange{ b, mid };
+                children[r * 2 + 1] = KdTreeRange{ mid + 1, e };
+            }
+        });
+
+        level.clear();
+        for (const KdTreeRange& range : next)
+        {
+            if (range.end - range.begin > KDTREE_LEAF_SIZE)
+                level.push_back(range);
+        }
+    }
+
+    m_x.resize(count);
+    m_y.resize(count);
+    m_z.resize(count);
+    m_indices.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_x[i] = entries[i].p[0];
+        m_y[i] = entries[i].p[1];
+        m_z[i] = entries[i].p[2];
+        m_indices[i] = entries[i].index;
+    }
+}
+
+void KdTree::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_indices.clear();
+    m_axes.clear();
+}
+
+uint32_t KdTree::nearest(const Vector3D& query, uint32_t k, uint32_t* indices, float* distancesSq) const
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    for (uint32_t i = 0; i < k; i++)
+    {
+        indices[i] = invalidIndex;
+        distancesSq[i] = infinity;
+    }
+    if (k == 0 || m_indices.empty())
+        return 0;
+
+    const float q[3] = { query.x, query.y, query.z };
+    const float* x = m_x.data();
+    const float* y = m_y.data();
+    const float* z = m_z.data();
+    uint32_t found = 0;
+
+    //Sorted insertion into the k best, distancesSq[k - 1] is the pruning bound once full
+    auto consider = [&](uint32_t i)
+    {
+        float dx = x[i] - q[0], dy = y[i] - q[1], dz = z[i] - q[2];
+        float d = dx * dx + dy * dy + dz * dz;
+        if (d >= distancesSq[k - 1])
+            return;
+
+        uint32_t slot = found < k ? found++ : k - 1;
+        while (slot > 0 && distancesSq[slot - 1] > d)
+        {
+            distancesSq[slot] = distancesSq[slot - 1];
+            indices[slot] = indices[slot - 1];
+            slot--;
+        }
+        distancesSq[slot] = d;
+        indices[slot] = i;
+    };
+
+    KdTreeStackEntry stack[KDTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = KdTreeStackEntry{ 0, (uint32_t)m_indices.size(), 0.0f };
+    while (top > 0)
+    {
+        KdTreeStackEntry entry = stack[--top];
+        if (entry.distanceSq >= distancesSq[k - 1])
+            continue;
+
+        if (entry.end - entry.begin <= KDTREE_LEAF_SIZE)
+        {
+            for (uint32_t i = entry.begin; i < entry.end; i++)
+                consider(i);
+            continue;
+        }
+
+        uint32_t mid = (entry.begin + entry.end) / 2;
+        consider(mid);
+
+        int axis = m_axes[mid];
+        float split = axis == 0 ? x[mid] : (axis == 1 ? y[mid] : z[mid]);
+        float diff = q[axis] - split;
+        KdTreeStackEntry left{ entry.begin, mid, entry.distanceSq };
+        KdTreeStackEntry right{ mid + 1, entry.end, entry.distanceSq };
+        KdTreeStackEntry& far = diff < 0.0f ? right : left;
+        far.distanceSq = std::max(entry.distanceSq, diff * diff);
+
+        //Near side is pushed last so it is visited first
+        stack[top++] = far;
+        stack[top++] = diff < 0.0f ? left : right;
+    }
+
+    for (uint32_t i = 0; i < found; i++)
+        indices[i] = m_indices[indices[i]];
+    return found;
+}
+
+size_t KdTree::withinRadius(const Vector3D& query, float radius, std::vector<uint32_t>& indices) const
+{
+    if (m_indices.empty() || radius < 0.0f)
+        return 0;
+
+    const float q[3] = { query.x, query.y, query.z };
+    const float radiusSq = radius * radius;
+    const float* x = m_x.data();
+    const float* y = m_y.data();
+    const float* z = m_z.data();
+    size_t first = indices.size();
+
+    auto consider = [&](uint32_t i)
+    {
+        float dx = x[i] - q[0], dy = y[i] - q[1], dz = z[i] - q[2];
+        if (dx * dx + dy * dy + dz * dz <= radiusSq)
+            indices.push_back(m_indices[i]);
+    };
+
+    KdTreeStackEntry stack[KDTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = KdTreeStackEntry{ 0, (uint32_t)m_indices.size(), 0.0f };
+    while (top > 0)
+    {
+        KdTreeStackEntry entry = stack[--top];
+        if (entry.distanceSq > radiusSq)
+            continue;
+
+        if (entry.end - entry.begin <= KDTREE_LEAF_SIZE)
+        {
+            for (uint32_t i = entry.begin; i < entry.end; i++)
+                consider(i);
+            continue;
+        }
+
+        uint32_t mid = (entry.begin + entry.end) / 2;
+        consider(mid);
+
+        int axis = m_axes[mid];
+        float split = axis == 0 ? x[mid] : (axis == 1 ? y[mid] : z[mid]);
+        float diff = q[axis] - split;
+        KdTreeStackEntry left{ entry.begin, mid, entry.distanceSq };
+        KdTreeStackEntry right{ mid + 1, entry.end, entry.distanceSq };
+        KdTreeStackEntry& far = diff < 0.0f ? right : left;
+        far.distanceSq = std::max(entry.distanceSq, diff * diff);
+        stack[top++] = far;
+        stack[top++] = diff < 0.0f ? left : right;
+    }
+
+    return indices.size() - first;
+}
+
+static uint32_t spreadBits(uint32_t v)
+{
+    v &= 0x3FF;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+//Query indices sorted along a Morton curve over the queries' bounding box
+void KdTree::order(const Vector3D* queries, size_t count, FrameArena& arena, uint32_t* ordered) const
+{
+    if (count == 0)
+        return;
+
+    float lo[3] = { queries[0].x, queries[0].y, queries[0].z };
+    float hi[3] = { lo[0], lo[1], lo[2] };
+    for (size_t i = 1; i < count; i++)
+    {
+        lo[0] = std::min(lo[0], queries[i].x);
+        lo[1] = std::min(lo[1], queries[i].y);
+        lo[2] = std::min(lo[2], queries[i].z);
+        hi[0] = std::max(hi[0], queries[i].x);
+        hi[1] = std::max(hi[1], queries[i].y);
+        hi[2] = std::max(hi[2], queries[i].z);
+    }
+
+    float scale[3];
+    for (int a = 0; a < 3; a++)
+        scale[a] = hi[a] > lo[a] ? 1023.0f / (hi[a] - lo[a]) : 0.0f;
+
+    uint64_t* keys = arena.allocate<uint64_t>(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t code = spreadBits((uint32_t)((queries[i].x - lo[0]) * scale[0])) |
+            (spreadBits((uint32_t)((queries[i].y - lo[1]) * scale[1])) << 1) |
+            (spreadBits((uint32_t)((queries[i].z - lo[2]) * scale[2])) << 2);
+        keys[i] = ((uint64_t)code << 32) | (uint64_t)i;
+    }
+    std::sort(keys, keys + count);
+    for (size_t i = 0; i < count; i++)
+        ordered[i] = (uint32_t)keys[i];
+}
+
+void KdTree::nearest(const Vector3D* queries, size_t count, uint32_t k, uint32_t* indices, float* distancesSq,
+    bool parallel) const
+{
+    //Scratch comes from the calling thread's arena, steady-state batches do not touch the heap
+    FrameArena& arena = FrameArena::getThreadArena();
+    FrameArenaScope scope(arena);
+    uint32_t* ordered = arena.allocate<uint32_t>(count);
+    order(queries, count, arena, ordered);
+    const uint32_t* sequence = ordered;
+    run(count, KDTREE_QUERY_CHUNK, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            size_t q = sequence[i];
+            nearest(queries[q], k, indices + q * k, distancesSq + q * k);
+        }
+    });
+}
+
+void KdTree::withinRadius(const Vector3D* queries, size_t count, float radius, std::vector<uint32_t>& offsets,
+    std::vector<uint32_t>& indices, bool parallel) const
+{
+    FrameArena& arena = FrameArena::getThreadArena();
+    FrameArenaScope scope(arena);
+    uint32_t* ordered = arena.allocate<uint32_t>(count);
+    order(queries, count, arena, ordered);
+
+    //Each block of ordered queries collects into its own list, merged afterwards
+    size_t blocks = (count + KDTREE_QUERY_CHUNK - 1) / KDTREE_QUERY_CHUNK;
+    std::vector<std::vector<uint32_t>> blockIndices(blocks);
+    offsets.assign(count + 1, 0);
+
+    const uint32_t* sequence = ordered;
+    std::vector<uint32_t>* lists = blockIndices.data();
+    uint32_t* counts = offsets.data() + 1;
+    uint32_t* localStarts = arena.allocate<uint32_t>(count);
+    run(blocks, 1, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t block = begin; block < end; block++)
+        {
+            size_t last = std::min(count, (block + 1) * KDTREE_QUERY_CHUNK);
+            for (size_t i = block * KDTREE_QUERY_CHUNK; i < last; i++)
+            {
+                size_t q = sequence[i];
+                localStarts[q] = (uint32_t)lists[block].size();
+                counts[q] = (uint32_t)withinRadius(queries[q], radius, lists[block]);
+            }
+        }
+    });
+
+    for (size_t q = 0; q < count; q++)
+        offsets[q + 1] += offsets[q];
+
+    indices.resize(offsets[count]);
+    uint32_t* out = indices.data();
+    const uint32_t* prefix = offsets.data();
+    run(blocks, 1, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t block = begin; block < end; block++)
+        {
+            size_t last = std::min(count, (block + 1) * KDTREE_QUERY_CHUNK);
+            for (size_t i = block * KDTREE_QUERY_CHUNK; i < last; i++)
+            {
+                size_t q = sequence[i];
+                uint32_t n = prefix[q + 1] - prefix[q];
+                std::copy(lists[block].begin() + localStarts[q], lists[block].begin() + localStarts[q] + n, out + prefix[q]);
+            }
+        }
+    });
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3D.h"
+#include "Export.h"
+
+class FrameArena;
+
+//Static point cloud search structure. The tree is implicit: points are reordered so that
+//the node of range [begin, end) is the median at (begin + end) / 2 and its children are
+//[begin, mid) and [mid + 1, end), no child pointers are stored. Ranges of at most
+//leafSize points are scanned linearly. Batched queries are visited in Morton order so
+//neighbouring queries reuse the same nodes while they are still in cache.
+class ESGS_EXPORT KdTree
+{
+public:
+	//Marks unused k-NN result slots
+	static const uint32_t invalidIndex = 0xFFFFFFFFu;
+
+	KdTree()
+	{
+	}
+
+	//Copies and reorders the points, results refer to indices into the original array
+	void build(const Vector3D* points, size_t count, bool parallel = true);
+	void clear();
+
+	size_t getCount() const { return m_indices.size(); }
+
+	//Up to k nearest points sorted by distance, returns how many were found
+	uint32_t nearest(const Vector3D& query, uint32_t k, uint32_t* indices, float* distancesSq) const;
+
+	//k slots per query, query i writes indices[i * k .. i * k + k), missing entries are
+	//invalidIndex with an infinite distance
+	void nearest(const Vector3D* queries, size_t count, uint32_t k, uint32_t* indices, float* distancesSq,
+		bool parallel = true) const;
+
+	//Appends all points within radius (unsorted), returns how many were appended
+	size_t withinRadius(const Vector3D& query, float radius, std::vector<uint32_t>& indices) const;
+
+	//Results of query i are indices[offsets[i] .. offsets[i + 1])
+	void withinRadius(const Vector3D* queries, size_t count, float radius, std::vector<uint32_t>& offsets,
+		std::vector<uint32_t>& indices, bool parallel = true) const;
+
+private:
+	//ordered holds count entries, the sort keys are scratch in arena
+	void order(const Vector3D* queries, size_t count, FrameArena& arena, uint32_t* ordered) const;
+
+private:
+	//Reordered points, structure of arrays
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+	std::vector<float> m_z;
+	//Original index of each reordered point
+	std::vector<uint32_t> m_indices;
+	//Split axis of the node stored at each position
+	std::vector<uint8_t> m_axes;
+};
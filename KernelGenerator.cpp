@@ -1,101 +1,108 @@
 #include "KernelGenerator.h"
-#include "Utilities.h"
-#include <d3d11.h>
-#include "GraphicsEngine.h"
-#include <DirectXMath.h>
-#include <DirectXPackedVector.h>
+#include "ProfileCounters.h"
+#include "StrictFloat.h"
+#include <map>
+#include <mutex>
 
-using namespace DirectX;
+//Kernels and offsets are promised identical for a seed on every platform
+ESGS_STRICT_FLOAT_BEGIN
 
-std::uniform_real_distribution<float> randomFloats(0.0f, 1.0f);
+static std::shared_ptr<const SSAOKernelSet> buildKernelSet(size_t kernelSize, uint32_t seed)
+{
+    ESGS_SCOPED_TIMER(KernelGeneration);
+    ESGS_COUNT(KernelGeneration, kernelSize);
+    std::shared_ptr<SSAOKernelSet> set = std::make_shared<SSAOKernelSet>();
+    set->seed = seed;
+    set->samples.resize(kernelSize);
+
+    KernelRandom random(seed);
+    for (size_t i = 0; i < kernelSize; i++)
+    {
+        float sample[3];
+        kernel_detail::ssaoSample(random, i, kernelSize, sample);
+        set->samples[i] = Vector3D(sample[0], sample[1], sample[2]);
+    }
+
+    // 8 cube corners followed by 6 face center point vectors
+    static const float directions[14][3] =
+    {
+        { +1.0f, +1.0f, +1.0f }, { -1.0f, -1.0f, -1.0f },
+        { -1.0f, +1.0f, +1.0f }, { +1.0f, -1.0f, -1.0f },
+        { +1.0f, +1.0f, -1.0f }, { -1.0f, -1.0f, +1.0f },
+        { -1.0f, +1.0f, -1.0f }, { +1.0f, -1.0f, +1.0f },
+        { -1.0f, 0.0f, 0.0f }, { +1.0f, 0.0f, 0.0f },
+        { 0.0f, -1.0f, 0.0f }, { 0.0f, +1.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, +1.0f }
+    };
+
+    KernelRandom offsetRandom(~(uint64_t)seed);
+    set->offsets.resize(14);
+    for (int i = 0; i < 14; ++i)
+    {
+        const float* d = directions[i];
+        float s = offsetRandom.nextFloat(0.25f, 1.0f) / kernel_detail::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        set->offsets[i] = Vector4D(d[0] * s, d[1] * s, d[2] * s, 0.0f);
+    }
+
+    return set;
+}
 
 KernelGenerator::KernelGenerator()
 {
 }
 
-KernelGenerator::~KernelGenerator()
+KernelGenerator::KernelGenerator(uint32_t seed) : m_seed(seed)
 {
 }
 
-void KernelGenerator::generateSSAOKernel()
+KernelGenerator::~KernelGenerator()
 {
-    DirectX::XMFLOAT3 tmpSample;
-    generator.seed(std::random_device()());
+}
 
-    std::vector<DirectX::PackedVector::XMCOLOR> randomVectors(256 * 256);
+std::shared_ptr<const SSAOKernelSet> KernelGenerator::getSSAOKernelSet(size_t kernelSize, uint32_t seed)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<size_t, uint32_t>, std::shared_ptr<const SSAOKernelSet>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const SSAOKernelSet>& entry = cache[std::make_pair(kernelSize, seed)];
+    if (!entry)
+        entry = buildKernelSet(kernelSize, seed);
+    return entry;
+}
 
+void KernelGenerator::generateSSAOKernel()
+{
+    std::shared_ptr<const SSAOKernelSet> set = getSSAOKernelSet(SSAO_KERNEL_SIZE, m_seed);
     for (int i = 0; i < SSAO_KERNEL_SIZE; i++)
-    {
-        tmpSample.x = randomFloats(generator) * 2.0f - 1.0f;
-        tmpSample.y = randomFloats(generator) * 2.0f - 1.0f;
-        tmpSample.z = randomFloats(generator);
-
-        DirectX::XMVECTOR tmpVector;
-        tmpVector.m128_f32[0] = tmpSample.x;
-        tmpVector.m128_f32[1] = tmpSample.y;
-        tmpVector.m128_f32[2] = tmpSample.z;
-
-        tmpVector = DirectX::XMVector3Normalize(tmpVector);
-
-        tmpSample.x = tmpVector.m128_f32[0];
-        tmpSample.y = tmpVector.m128_f32[1];
-        tmpSample.z = tmpVector.m128_f32[2];
-
-        float scale = float(i) / 64.0f;
-        scale = lerp(0.1f, 1.0f, scale * scale);
-        tmpSample.x *= scale;
-        tmpSample.y *= scale;
-        tmpSample.z *= scale;
-
-        m_ssao_kernel[i] = tmpSample;
-    }
+        m_ssao_kernel[i] = set->samples[i];
 }
 
 void KernelGenerator::generateOffsetVectors()
 {
-    m_ssao_offset[0] = DirectX::XMFLOAT4(+1.0f, +1.0f, +1.0f, 0.0f);
-    m_ssao_offset[1] = DirectX::XMFLOAT4(-1.0f, -1.0f, -1.0f, 0.0f);
-
-    m_ssao_offset[2] = DirectX::XMFLOAT4(-1.0f, +1.0f, +1.0f, 0.0f);
-    m_ssao_offset[3] = DirectX::XMFLOAT4(+1.0f, -1.0f, -1.0f, 0.0f);
-
-    m_ssao_offset[4] = DirectX::XMFLOAT4(+1.0f, +1.0f, -1.0f, 0.0f);
-    m_ssao_offset[5] = DirectX::XMFLOAT4(-1.0f, -1.0f, +1.0f, 0.0f);
-
-    m_ssao_offset[6] = DirectX::XMFLOAT4(-1.0f, +1.0f, -1.0f, 0.0f);
-    m_ssao_offset[7] = DirectX::XMFLOAT4(+1.0f, -1.0f, +1.0f, 0.0f);
-
-    // 6 face center point vectors
-    m_ssao_offset[8] = DirectX::XMFLOAT4(-1.0f, 0.0f, 0.0f, 0.0f);
-    m_ssao_offset[9] = DirectX::XMFLOAT4(+1.0f, 0.0f, 0.0f, 0.0f);
-
-    m_ssao_offset[10] = DirectX::XMFLOAT4(0.0f, -1.0f, 0.0f, 0.0f);
-    m_ssao_offset[11] = DirectX::XMFLOAT4(0.0f, +1.0f, 0.0f, 0.0f);
-
-    m_ssao_offset[12] = DirectX::XMFLOAT4(0.0f, 0.0f, -1.0f, 0.0f);
-    m_ssao_offset[13] = DirectX::XMFLOAT4(0.0f, 0.0f, +1.0f, 0.0f);
-
-
-    std::default_random_engine generator;
-    generator.seed(std::random_device()());
-    std::uniform_real_distribution<float> randomFloatsOffset(0.25f, 1.0f);
-
-    for (int i = 0; i < 14; ++i)
-    {
-        float s = randomFloatsOffset(generator);
-
-        DirectX::XMVECTOR v = s * DirectX::XMVector4Normalize(DirectX::XMLoadFloat4(&m_ssao_offset[i]));
-
-        DirectX::XMStoreFloat4(&m_ssao_offset[i], v);
-    }
+    std::shared_ptr<const SSAOKernelSet> set = getSSAOKernelSet(SSAO_KERNEL_SIZE, m_seed);
+    for (int i = 0; i < SSAO_OFFSET_SIZE && i < (int)set->offsets.size(); i++)
+        m_ssao_offset[i] = set->offsets[i];
 }
 
-DirectX::XMFLOAT3* KernelGenerator::getSSAOKernel()
+Vector3D* KernelGenerator::getSSAOKernel()
 {
     return m_ssao_kernel;
 }
 
-DirectX::XMFLOAT4* KernelGenerator::getSSAOOffset()
+Vector4D* KernelGenerator::getSSAOOffset()
 {
     return m_ssao_offset;
-}
\ No newline at end of file
+}
+
+void KernelGenerator::setSeed(uint32_t seed)
+{
+    m_seed = seed;
+}
+
+uint32_t KernelGenerator::getSeed() const
+{
+    return m_seed;
+}
+
+ESGS_STRICT_FLOAT_END
@@ -1,7 +1,13 @@
 #pragma once
-#include <random>
-#include <DirectXMath.h>
-#include <d3d11.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
 
 #ifndef SSAO_KERNEL_SIZE
 #define SSAO_KERNEL_SIZE 64
@@ -11,24 +17,204 @@
 #define SSAO_OFFSET_SIZE 14
 #endif // !SSAO_KERNEL_SIZE
 
+#ifndef SSAO_KERNEL_SEED
+#define SSAO_KERNEL_SEED 0x55A0u
+#endif // !SSAO_KERNEL_SEED
+
+//Kernel generation must match between constant evaluation and runtime. The runtime
+//path is KernelGenerator.cpp, which disables FP contraction around these helpers
+
+//PCG32, gives the same sequence on every platform and in constant expressions
+struct KernelRandom
+{
+	constexpr KernelRandom(uint64_t seed) : state(seed * 6364136223846793005ull + 1442695040888963407ull)
+	{
+	}
+
+	constexpr uint32_t next()
+	{
+		uint64_t old = state;
+		state = old * 6364136223846793005ull + 1442695040888963407ull;
+		uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+		uint32_t rot = (uint32_t)(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+	}
+
+	//[0, 1)
+	constexpr float nextFloat()
+	{
+		return (float)(next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	constexpr float nextFloat(float lo, float hi)
+	{
+		return lo + (hi - lo) * nextFloat();
+	}
+
+	uint64_t state;
+};
+
+namespace kernel_detail
+{
+	//Newton iteration instead of sqrtf so results do not depend on the C runtime
+	constexpr float sqrt(float v)
+	{
+		if (!(v > 0.0f))
+			return 0.0f;
+
+		float x = v > 1.0f ? v : 1.0f;
+		for (int i = 0; i < 32; i++)
+		{
+			float n = 0.5f * (x + v / x);
+			if (n == x)
+				break;
+			x = n;
+		}
+		return x;
+	}
+
+	//Hemisphere sample i of size, scaled towards the center
+	constexpr void ssaoSample(KernelRandom& random, size_t i, size_t size, float out[3])
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f, len = 0.0f;
+		do
+		{
+			x = random.nextFloat(-1.0f, 1.0f);
+			y = random.nextFloat(-1.0f, 1.0f);
+			z = random.nextFloat();
+			len = sqrt(x * x + y * y + z * z);
+		} while (len < 0.0001f);
+
+		float scale = float(i) / float(size);
+		scale = 0.1f + (1.0f - 0.1f) * (scale * scale);
+		scale /= len;
+
+		out[0] = x * scale;
+		out[1] = y * scale;
+		out[2] = z * scale;
+	}
+
+	template<size_t Size>
+	constexpr std::array<float, Size * 3> ssaoKernel(uint32_t seed)
+	{
+		std::array<float, Size * 3> kernel = {};
+		KernelRandom random(seed);
+		for (size_t i = 0; i < Size; i++)
+		{
+			float sample[3] = {};
+			ssaoSample(random, i, Size, sample);
+			kernel[i * 3 + 0] = sample[0];
+			kernel[i * 3 + 1] = sample[1];
+			kernel[i * 3 + 2] = sample[2];
+		}
+		return kernel;
+	}
+}
+
+//Immutable result of one (size, seed) pair, shared between all users
+struct SSAOKernelSet
+{
+	uint32_t seed = 0;
+	std::vector<Vector3D> samples;
+	std::vector<Vector4D> offsets;
+};
+
+enum class SampleSequence : uint8_t
+{
+	Random,
+	Halton,
+	Sobol,
+	R2,
+	//Dart throwing with a shrinking radius
+	PoissonDisk,
+	//Mitchell's best candidate
+	BlueNoise
+};
+
+enum class SampleDomain : uint8_t
+{
+	//[0, 1)^2, z = 0
+	Square,
+	//Unit disk, z = 0
+	Disk,
+	//Cosine weighted unit hemisphere around +z
+	Hemisphere,
+	//Unit sphere surface
+	Sphere
+};
+
+struct SampleSet
+{
+	SampleSequence sequence = SampleSequence::Random;
+	SampleDomain domain = SampleDomain::Square;
+	uint32_t seed = 0;
+	std::vector<Vector3D> points;
+};
+
+//Tiled per-pixel rotations (cos, sin) for randomizing a kernel across the screen
+struct RotationNoise
+{
+	SampleSequence sequence = SampleSequence::Random;
+	uint32_t seed = 0;
+	uint32_t size = 0;
+	std::vector<Vector2D> rotations;
+};
+
+//Samples are laid out like XMFLOAT3/XMFLOAT4, see DirectXInterop.h for views
 class KernelGenerator
 {
 public:
 	KernelGenerator();
+	KernelGenerator(uint32_t seed);
 	~KernelGenerator();
 
 	void generateSSAOKernel();
 	void generateOffsetVectors();
 
-	DirectX::XMFLOAT3* getSSAOKernel();
-	DirectX::XMFLOAT4* getSSAOOffset();
+	Vector3D* getSSAOKernel();
+	Vector4D* getSSAOOffset();
+
+	void setSeed(uint32_t seed);
+	uint32_t getSeed() const;
+
+	//Generated on first request and cached, later calls with the same arguments
+	//return the same set. Safe to call from any thread.
+	static std::shared_ptr<const SSAOKernelSet> getSSAOKernelSet(size_t kernelSize, uint32_t seed = SSAO_KERNEL_SEED);
+
+	//Same samples as getSSAOKernelSet(KernelSize, Seed), evaluated at compile time
+	//when used in a constant expression (C++17, std::array::operator[] is not
+	//constexpr before). Packed xyz.
+	template<size_t KernelSize, uint32_t Seed = SSAO_KERNEL_SEED>
+	static constexpr std::array<float, KernelSize * 3> makeSSAOKernel()
+	{
+		return kernel_detail::ssaoKernel<KernelSize>(Seed);
+	}
+
+	//Cached like getSSAOKernelSet. Sequences are generated in parallel and mapped
+	//to the domain with SSE, PoissonDisk and BlueNoise measure distances in the domain.
+	static std::shared_ptr<const SampleSet> getSampleSet(SampleSequence sequence, SampleDomain domain,
+		uint32_t count, uint32_t seed = SSAO_KERNEL_SEED);
+
+	//Maps [0, 1)^2 points onto domain, as getSampleSet does. simd = false forces the
+	//scalar path, which must give the same bits as the SSE path.
+	static void mapSamples(SampleDomain domain, const float* u, const float* v, float* x, float* y, float* z,
+		size_t count, bool simd = true);
+
+	//size x size tile. BlueNoise ranks pixels with void-and-cluster, R2 uses the R2 dither.
+	static std::shared_ptr<const RotationNoise> getRotationNoise(SampleSequence sequence, uint32_t size,
+		uint32_t seed = SSAO_KERNEL_SEED);
+
+	//Binary cache of every sample set and noise tile generated so far, loaded
+	//entries are served by getSampleSet/getRotationNoise without regeneration.
+	static bool saveSampleCache(const std::string& path);
+	static bool loadSampleCache(const std::string& path);
 
 private:
-	std::default_random_engine generator;
+	uint32_t m_seed = SSAO_KERNEL_SEED;
 
 
-	DirectX::XMFLOAT3 m_ssao_kernel[SSAO_KERNEL_SIZE];
+	Vector3D m_ssao_kernel[SSAO_KERNEL_SIZE];
 
 
-	DirectX::XMFLOAT4 m_ssao_offset[SSAO_OFFSET_SIZE];
+	Vector4D m_ssao_offset[SSAO_OFFSET_SIZE];
 };
\ No newline at end of file
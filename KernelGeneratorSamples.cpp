@@ -0,0 +1,601 @@
+#include "KernelGenerator.h"
+#include "SampleSequences.h"
+#include "AsyncCore.h"
+#include "ProfileCounters.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+//Sample sets and the binary cache must not depend on the build or on which points
+//go through SSE, so nothing in here is contracted
+ESGS_STRICT_FLOAT_BEGIN
+
+static const float twoPi = 6.28318530717958647692f;
+static const float halfPi = 1.57079632679489661923f;
+
+//Taylor polynomials on [-pi/2, pi/2], identical for the SSE and scalar paths so that
+//results do not depend on the C runtime or on how many points go through SSE
+static void sinCos(float angle, float& s, float& c)
+{
+    //sin(angle) = -sin(a), cos(angle) = -cos(a), reflecting a into range flips the cosine
+    float a = angle - 3.14159265358979323846f;
+    float cosSign = -1.0f;
+    if (a > halfPi)
+    {
+        a = 3.14159265358979323846f - a;
+        cosSign = 1.0f;
+    }
+    else if (a < -halfPi)
+    {
+        a = -3.14159265358979323846f - a;
+        cosSign = 1.0f;
+    }
+
+    float a2 = a * a;
+    float sinA = a * (1.0f + a2 * (-1.0f / 6.0f + a2 * (1.0f / 120.0f + a2 * (-1.0f / 5040.0f + a2 * (1.0f / 362880.0f + a2 * (-1.0f / 39916800.0f))))));
+    float cosA = 1.0f + a2 * (-0.5f + a2 * (1.0f / 24.0f + a2 * (-1.0f / 720.0f + a2 * (1.0f / 40320.0f + a2 * (-1.0f / 3628800.0f + a2 * (1.0f / 479001600.0f))))));
+
+    s = -sinA;
+    c = cosSign * cosA;
+}
+
+static void mapPoint(SampleDomain domain, float u, float v, float& x, float& y, float& z)
+{
+    if (domain == SampleDomain::Square)
+    {
+        x = u;
+        y = v;
+        z = 0.0f;
+        return;
+    }
+
+    float s, c;
+    sinCos(v * twoPi, s, c);
+
+    if (domain == SampleDomain::Sphere)
+    {
+        z = 1.0f - 2.0f * u;
+        float r = sqrtf(std::max(0.0f, 1.0f - z * z));
+        x = r * c;
+        y = r * s;
+        return;
+    }
+
+    float r = sqrtf(u);
+    x = r * c;
+    y = r * s;
+    z = domain == SampleDomain::Hemisphere ? sqrtf(std::max(0.0f, 1.0f - u)) : 0.0f;
+}
+
+#ifdef ESGS_SSE2
+static __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void sinCos4(__m128 angle, __m128& s, __m128& c)
+{
+    __m128 pi = _mm_set1_ps(3.14159265358979323846f);
+    __m128 hp = _mm_set1_ps(halfPi);
+    __m128 a = _mm_sub_ps(angle, pi);
+    __m128 above = _mm_cmpgt_ps(a, hp);
+    __m128 below = _mm_cmplt_ps(a, _mm_sub_ps(_mm_setzero_ps(), hp));
+    a = select(above, _mm_sub_ps(pi, a), select(below, _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), pi), a), a));
+    __m128 cosSign = select(_mm_or_ps(above, below), _mm_set1_ps(1.0f), _mm_set1_ps(-1.0f));
+
+    __m128 a2 = _mm_mul_ps(a, a);
+    __m128 ps = _mm_set1_ps(-1.0f / 39916800.0f);
+    ps = _mm_add_ps(_mm_set1_ps(1.0f / 362880.0f), _mm_mul_ps(a2, ps));
+    ps = _mm_add_ps(_mm_set1_ps(-1.0f / 5040.0f), _mm_mul_ps(a2, ps));
+    ps = _mm_add_ps(_mm_set1_ps(1.0f / 120.0f), _mm_mul_ps(a2, ps));
+    ps = _mm_add_ps(_mm_set1_ps(-1.0f / 6.0f), _mm_mul_ps(a2, ps));
+    ps = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(a2, ps));
+    ps = _mm_mul_ps(a, ps);
+
+    __m128 pc = _mm_set1_ps(1.0f / 479001600.0f);
+    pc = _mm_add_ps(_mm_set1_ps(-1.0f / 3628800.0f), _mm_mul_ps(a2, pc));
+    pc = _mm_add_ps(_mm_set1_ps(1.0f / 40320.0f), _mm_mul_ps(a2, pc));
+    pc = _mm_add_ps(_mm_set1_ps(-1.0f / 720.0f), _mm_mul_ps(a2, pc));
+    pc = _mm_add_ps(_mm_set1_ps(1.0f / 24.0f), _mm_mul_ps(a2, pc));
+    pc = _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(a2, pc));
+    pc = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(a2, pc));
+
+    //Sign flip like the scalar -sinA, 0 - x would give +0 where the scalar path gives -0
+    s = _mm_xor_ps(ps, _mm_set1_ps(-0.0f));
+    c = _mm_mul_ps(cosSign, pc);
+}
+#endif
+
+//u, v in, x, y, z out, all count long
+static void mapPoints(SampleDomain domain, const float* u, const float* v, float* x, float* y, float* z, size_t count,
+    bool simd = true)
+{
+    size_t i = 0;
+
+#ifdef ESGS_SSE2
+    if (simd && domain != SampleDomain::Square)
+    {
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 vu = _mm_loadu_ps(u + i);
+            __m128 s, c;
+            sinCos4(_mm_mul_ps(_mm_loadu_ps(v + i), _mm_set1_ps(twoPi)), s, c);
+
+            __m128 r, vz;
+            if (domain == SampleDomain::Sphere)
+            {
+                vz = _mm_sub_ps(one, _mm_add_ps(vu, vu));
+                r = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(vz, vz))));
+            }
+            else
+            {
+                r = _mm_sqrt_ps(vu);
+                vz = domain == SampleDomain::Hemisphere ? _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(one, vu))) : zero;
+            }
+
+            _mm_storeu_ps(x + i, _mm_mul_ps(r, c));
+            _mm_storeu_ps(y + i, _mm_mul_ps(r, s));
+            _mm_storeu_ps(z + i, vz);
+        }
+    }
+#else
+    (void)simd;
+#endif
+
+    for (; i < count; i++)
+        mapPoint(domain, u[i], v[i], x[i], y[i], z[i]);
+}
+
+void KernelGenerator::mapSamples(SampleDomain domain, const float* u, const float* v, float* x, float* y, float* z,
+    size_t count, bool simd)
+{
+    mapPoints(domain, u, v, x, y, z, count, simd);
+}
+
+static float wrap(float v)
+{
+    return v >= 1.0f ? v - 1.0f : v;
+}
+
+//Unit square coordinates of sequence point i. Halton and R2 get a Cranley-Patterson
+//shift, Sobol a digit scramble, so every seed keeps the low discrepancy.
+static void sequencePoint(SampleSequence sequence, uint32_t index, uint32_t seed, float& u, float& v)
+{
+    KernelRandom scramble(seed);
+    switch (sequence)
+    {
+    case SampleSequence::Halton:
+        u = wrap(sample_sequences::halton(index + 1, 0) + scramble.nextFloat());
+        v = wrap(sample_sequences::halton(index + 1, 1) + scramble.nextFloat());
+        return;
+    case SampleSequence::Sobol:
+    {
+        uint32_t s0 = scramble.next();
+        uint32_t s1 = scramble.next();
+        u = sample_sequences::sobol(index, 0, s0);
+        v = sample_sequences::sobol(index, 1, s1);
+        return;
+    }
+    case SampleSequence::R2:
+        u = wrap(sample_sequences::r2(index, 0) + scramble.nextFloat());
+        v = wrap(sample_sequences::r2(index, 1) + scramble.nextFloat());
+        return;
+    default:
+    {
+        KernelRandom random(((uint64_t)seed << 32) | index);
+        u = random.nextFloat();
+        v = random.nextFloat();
+        return;
+    }
+    }
+}
+
+static float minDistanceSq(const std::vector<float>& px, const std::vector<float>& py, const std::vector<float>& pz,
+    float x, float y, float z)
+{
+    size_t count = px.size();
+    size_t i = 0;
+    float best = 3.4e38f;
+
+#ifdef ESGS_SSE2
+    __m128 cx = _mm_set1_ps(x);
+    __m128 cy = _mm_set1_ps(y);
+    __m128 cz = _mm_set1_ps(z);
+    __m128 bestV = _mm_set1_ps(best);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&px[i]), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&py[i]), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&pz[i]), cz);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        bestV = _mm_min_ps(bestV, d);
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, bestV);
+    for (int k = 0; k < 4; k++)
+        best = std::min(best, lanes[k]);
+#endif
+
+    for (; i < count; i++)
+    {
+        float dx = px[i] - x, dy = py[i] - y, dz = pz[i] - z;
+        best = std::min(best, dx * dx + dy * dy + dz * dz);
+    }
+
+    return best;
+}
+
+//Poisson disk and best candidate sets. Hemisphere points are placed on the disk and
+//lifted afterwards, which keeps them cosine weighted (Malley's method).
+static void generateSpaced(SampleSequence sequence, SampleDomain domain, uint32_t count, uint32_t seed, std::vector<Vector3D>& points)
+{
+    SampleDomain metric = domain == SampleDomain::Hemisphere ? SampleDomain::Disk : domain;
+    std::vector<float> px, py, pz;
+    px.reserve(count);
+    py.reserve(count);
+    pz.reserve(count);
+
+    KernelRandom random(seed);
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+
+    if (sequence == SampleSequence::PoissonDisk)
+    {
+        float area = metric == SampleDomain::Square ? 1.0f : (metric == SampleDomain::Disk ? 3.14159265f : 4.0f * 3.14159265f);
+        float radius = 2.0f * sqrtf(area / (3.14159265f * float(count)));
+        int failures = 0;
+        while (px.size() < count)
+        {
+            mapPoint(metric, random.nextFloat(), random.nextFloat(), x, y, z);
+            if (px.empty() || minDistanceSq(px, py, pz, x, y, z) >= radius * radius)
+            {
+                px.push_back(x);
+                py.push_back(y);
+                pz.push_back(z);
+                failures = 0;
+            }
+            else if (++failures > 64)
+            {
+                radius *= 0.95f;
+                failures = 0;
+            }
+        }
+    }
+    else
+    {
+        const int candidates = 16;
+        while (px.size() < count)
+        {
+            float bestX = 0.0f, bestY = 0.0f, bestZ = 0.0f, bestDistance = -1.0f;
+            for (int c = 0; c < candidates; c++)
+            {
+                mapPoint(metric, random.nextFloat(), random.nextFloat(), x, y, z);
+                float d = px.empty() ? 0.0f : minDistanceSq(px, py, pz, x, y, z);
+                if (d > bestDistance)
+                {
+                    bestDistance = d;
+                    bestX = x;
+                    bestY = y;
+                    bestZ = z;
+                }
+            }
+            px.push_back(bestX);
+            py.push_back(bestY);
+            pz.push_back(bestZ);
+        }
+    }
+
+    points.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float lift = domain == SampleDomain::Hemisphere ? sqrtf(std::max(0.0f, 1.0f - px[i] * px[i] - py[i] * py[i])) : pz[i];
+        points[i] = Vector3D(px[i], py[i], lift);
+    }
+}
+
+static std::shared_ptr<const SampleSet> buildSampleSet(SampleSequence sequence, SampleDomain domain, uint32_t count, uint32_t seed)
+{
+    ESGS_SCOPED_TIMER(KernelGeneration);
+    ESGS_COUNT(KernelGeneration, count);
+    std::shared_ptr<SampleSet> set = std::make_shared<SampleSet>();
+    set->sequence = sequence;
+    set->domain = domain;
+    set->seed = seed;
+
+    if (sequence == SampleSequence::PoissonDisk || sequence == SampleSequence::BlueNoise)
+    {
+        generateSpaced(sequence, domain, count, seed, set->points);
+        return set;
+    }
+
+    std::vector<float> buffer((size_t)count * 5);
+    float* u = buffer.data();
+    float* v = u + count;
+    float* x = v + count;
+    float* y = x + count;
+    float* z = y + count;
+
+    __parallel_for(count, 4096, [=](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                sequencePoint(sequence, (uint32_t)i, seed, u[i], v[i]);
+            mapPoints(domain, u + begin, v + begin, x + begin, y + begin, z + begin, end - begin);
+        });
+
+    set->points.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        set->points[i] = Vector3D(x[i], y[i], z[i]);
+
+    return set;
+}
+
+//Void-and-cluster style ranking: every pixel goes to the emptiest spot of a toroidal
+//Gaussian energy field, so consecutive ranks are spread out like blue noise
+static void rankBlueNoise(uint32_t size, uint32_t seed, std::vector<uint32_t>& rank)
+{
+    size_t n = (size_t)size * size;
+    const float sigma = 1.5f;
+
+    std::vector<float> kernel(n);
+    for (uint32_t dy = 0; dy < size; dy++)
+    {
+        for (uint32_t dx = 0; dx < size; dx++)
+        {
+            float wx = (float)std::min(dx, size - dx);
+            float wy = (float)std::min(dy, size - dy);
+            kernel[dy * size + dx] = expf(-(wx * wx + wy * wy) / (2.0f * sigma * sigma));
+        }
+    }
+
+    std::vector<float> energy(n, 0.0f);
+    rank.assign(n, 0);
+    std::vector<uint8_t> placed(n, 0);
+
+    KernelRandom random(seed);
+    size_t pixel = random.next() % n;
+
+    for (size_t r = 0; r < n; r++)
+    {
+        if (r > 0)
+        {
+            float lowest = 3.4e38f;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (!placed[i] && energy[i] < lowest)
+                {
+                    lowest = energy[i];
+                    pixel = i;
+                }
+            }
+        }
+
+        placed[pixel] = 1;
+        rank[pixel] = (uint32_t)r;
+
+        uint32_t px = (uint32_t)(pixel % size);
+        uint32_t py = (uint32_t)(pixel / size);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            const float* row = &kernel[((y + size - py) % size) * size];
+            float* target = &energy[(size_t)y * size];
+            for (uint32_t x = 0; x < size; x++)
+                target[x] += row[(x + size - px) % size];
+        }
+    }
+}
+
+static std::shared_ptr<const RotationNoise> buildRotationNoise(SampleSequence sequence, uint32_t size, uint32_t seed)
+{
+    ESGS_SCOPED_TIMER(KernelGeneration);
+    ESGS_COUNT(KernelGeneration, size * size);
+    std::shared_ptr<RotationNoise> noise = std::make_shared<RotationNoise>();
+    noise->sequence = sequence;
+    noise->seed = seed;
+    noise->size = size;
+    if (size == 0)
+        return noise;
+
+    size_t n = (size_t)size * size;
+    std::vector<float> angle(n);
+
+    if (sequence == SampleSequence::BlueNoise || sequence == SampleSequence::PoissonDisk)
+    {
+        std::vector<uint32_t> rank;
+        rankBlueNoise(size, seed, rank);
+        for (size_t i = 0; i < n; i++)
+            angle[i] = (float(rank[i]) + 0.5f) / float(n);
+    }
+    else
+    {
+        float shift = KernelRandom(seed).nextFloat();
+        float* out = angle.data();
+        __parallel_for(size, 64, [=](size_t begin, size_t end)
+            {
+                for (size_t y = begin; y < end; y++)
+                {
+                    for (uint32_t x = 0; x < size; x++)
+                    {
+                        size_t i = y * size + x;
+                        float v = 0.0f, unused = 0.0f;
+                        if (sequence == SampleSequence::R2)
+                        {
+                            double d = 0.5 + sample_sequences::r2Alpha1 * x + sample_sequences::r2Alpha2 * y + shift;
+                            v = float(d - double(int64_t(d)));
+                        }
+                        else
+                        {
+                            sequencePoint(sequence, (uint32_t)i, seed, v, unused);
+                        }
+                        out[i] = v < 1.0f ? v : 0.0f;
+                    }
+                }
+            });
+    }
+
+    noise->rotations.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        float s, c;
+        sinCos(angle[i] * twoPi, s, c);
+        noise->rotations[i] = Vector2D(c, s);
+    }
+
+    return noise;
+}
+
+//kind 0 is a sample set, kind 1 a rotation noise tile
+typedef std::tuple<uint8_t, uint8_t, uint8_t, uint32_t, uint32_t> SampleCacheKey;
+
+static std::mutex sampleCacheMutex;
+static std::map<SampleCacheKey, std::shared_ptr<const SampleSet>> sampleSetCache;
+static std::map<SampleCacheKey, std::shared_ptr<const RotationNoise>> rotationNoiseCache;
+
+std::shared_ptr<const SampleSet> KernelGenerator::getSampleSet(SampleSequence sequence, SampleDomain domain, uint32_t count, uint32_t seed)
+{
+    SampleCacheKey key((uint8_t)0, (uint8_t)sequence, (uint8_t)domain, count, seed);
+    {
+        std::lock_guard<std::mutex> lock(sampleCacheMutex);
+        auto it = sampleSetCache.find(key);
+        if (it != sampleSetCache.end())
+            return it->second;
+    }
+
+    //Built outside the lock, a concurrent duplicate build keeps the first result
+    std::shared_ptr<const SampleSet> set = buildSampleSet(sequence, domain, count, seed);
+    std::lock_guard<std::mutex> lock(sampleCacheMutex);
+    return sampleSetCache.emplace(key, set).first->second;
+}
+
+std::shared_ptr<const RotationNoise> KernelGenerator::getRotationNoise(SampleSequence sequence, uint32_t size, uint32_t seed)
+{
+    SampleCacheKey key((uint8_t)1, (uint8_t)sequence, (uint8_t)0, size, seed);
+    {
+        std::lock_guard<std::mutex> lock(sampleCacheMutex);
+        auto it = rotationNoiseCache.find(key);
+        if (it != rotationNoiseCache.end())
+            return it->second;
+    }
+
+    std::shared_ptr<const RotationNoise> noise = buildRotationNoise(sequence, size, seed);
+    std::lock_guard<std::mutex> lock(sampleCacheMutex);
+    return rotationNoiseCache.emplace(key, noise).first->second;
+}
+
+//File layout: "ESGSSMP" + version byte, uint32 entry count, then per entry
+//kind, sequence, domain, reserved (1 byte each), uint32 count, uint32 seed,
+//uint32 float count and the raw floats
+static const char sampleCacheMagic[8] = { 'E', 'S', 'G', 'S', 'S', 'M', 'P', 1 };
+
+static bool writeEntry(FILE* file, const SampleCacheKey& key, const float* data, uint32_t floats)
+{
+    uint8_t header[4] = { std::get<0>(key), std::get<1>(key), std::get<2>(key), 0 };
+    uint32_t values[3] = { std::get<3>(key), std::get<4>(key), floats };
+    return fwrite(header, 1, 4, file) == 4 && fwrite(values, 4, 3, file) == 3 &&
+        fwrite(data, sizeof(float), floats, file) == floats;
+}
+
+bool KernelGenerator::saveSampleCache(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(sampleCacheMutex);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    uint32_t entries = (uint32_t)(sampleSetCache.size() + rotationNoiseCache.size());
+    bool ok = fwrite(sampleCacheMagic, 1, 8, file) == 8 && fwrite(&entries, 4, 1, file) == 1;
+
+    for (auto it = sampleSetCache.begin(); ok && it != sampleSetCache.end(); ++it)
+        ok = writeEntry(file, it->first, reinterpret_cast<const float*>(it->second->points.data()), (uint32_t)it->second->points.size() * 3);
+    for (auto it = rotationNoiseCache.begin(); ok && it != rotationNoiseCache.end(); ++it)
+        ok = writeEntry(file, it->first, reinterpret_cast<const float*>(it->second->rotations.data()), (uint32_t)it->second->rotations.size() * 2);
+
+    return fclose(file) == 0 && ok;
+}
+
+bool KernelGenerator::loadSampleCache(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    //Entry sizes are checked against the bytes left so a corrupt header cannot request a huge allocation
+    long fileSize = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        fileSize = ftell(file);
+    rewind(file);
+
+    char magic[8];
+    uint32_t entries = 0;
+    bool ok = fileSize >= 0 && fread(magic, 1, 8, file) == 8 && ::memcmp(magic, sampleCacheMagic, 8) == 0 && fread(&entries, 4, 1, file) == 1;
+
+    std::map<SampleCacheKey, std::shared_ptr<const SampleSet>> sets;
+    std::map<SampleCacheKey, std::shared_ptr<const RotationNoise>> noises;
+
+    for (uint32_t e = 0; ok && e < entries; e++)
+    {
+        uint8_t header[4];
+        uint32_t values[3];
+        ok = fread(header, 1, 4, file) == 4 && fread(values, 4, 3, file) == 3;
+        if (!ok)
+            break;
+
+        uint64_t expected = header[0] == 0 ? (uint64_t)values[0] * 3 : (uint64_t)values[0] * values[0] * 2;
+        long position = ftell(file);
+        ok = header[0] <= 1 && values[2] == expected && position >= 0 &&
+            expected * sizeof(float) <= (uint64_t)(fileSize - position);
+        if (!ok)
+            break;
+
+        SampleCacheKey key(header[0], header[1], header[2], values[0], values[1]);
+        std::vector<float> data(values[2]);
+        ok = fread(data.data(), sizeof(float), data.size(), file) == data.size();
+        if (!ok)
+            break;
+
+        if (header[0] == 0 && data.size() == (size_t)values[0] * 3)
+        {
+            std::shared_ptr<SampleSet> set = std::make_shared<SampleSet>();
+            set->sequence = (SampleSequence)header[1];
+            set->domain = (SampleDomain)header[2];
+            set->seed = values[1];
+            set->points.resize(values[0]);
+            for (uint32_t i = 0; i < values[0]; i++)
+                set->points[i] = Vector3D(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+            sets[key] = set;
+        }
+        else if (header[0] == 1 && data.size() == (size_t)values[0] * values[0] * 2)
+        {
+            std::shared_ptr<RotationNoise> noise = std::make_shared<RotationNoise>();
+            noise->sequence = (SampleSequence)header[1];
+            noise->seed = values[1];
+            noise->size = values[0];
+            noise->rotations.resize(data.size() / 2);
+            for (size_t i = 0; i < noise->rotations.size(); i++)
+                noise->rotations[i] = Vector2D(data[i * 2], data[i * 2 + 1]);
+            noises[key] = noise;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    fclose(file);
+    if (!ok)
+        return false;
+
+    std::lock_guard<std::mutex> lock(sampleCacheMutex);
+    sampleSetCache.insert(sets.begin(), sets.end());
+    rotationNoiseCache.insert(noises.begin(), noises.end());
+    return true;
+}
+
+ESGS_STRICT_FLOAT_END
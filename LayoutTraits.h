@@ -0,0 +1,48 @@
+#pragma once
+#include <type_traits>
+
+class Quaternion;
+class Vector3A;
+
+//Member detection used for conversion from foreign vector and matrix types
+//(PxVec3, XMFLOAT3, PxMat44, ...) without including their headers. Those convert
+//implicitly; kit types that merely have xyzw members (Quaternion, Vector3A with its
+//padding w) are excluded so they never convert silently.
+namespace layout_traits
+{
+	template<typename T> struct is_kit_type : std::false_type {};
+	template<> struct is_kit_type<Quaternion> : std::true_type {};
+	template<> struct is_kit_type<Vector3A> : std::true_type {};
+
+	template<typename T, typename = void> struct has_x : std::false_type {};
+	template<typename T> struct has_x<T, decltype((void)std::declval<const T&>().x)> : std::true_type {};
+
+	template<typename T, typename = void> struct has_y : std::false_type {};
+	template<typename T> struct has_y<T, decltype((void)std::declval<const T&>().y)> : std::true_type {};
+
+	template<typename T, typename = void> struct has_z : std::false_type {};
+	template<typename T> struct has_z<T, decltype((void)std::declval<const T&>().z)> : std::true_type {};
+
+	template<typename T, typename = void> struct has_w : std::false_type {};
+	template<typename T> struct has_w<T, decltype((void)std::declval<const T&>().w)> : std::true_type {};
+
+	template<typename T, typename = void> struct has_columns : std::false_type {};
+	template<typename T> struct has_columns<T, decltype((void)std::declval<const T&>().column3)> : std::true_type {};
+
+	template<typename T, typename Self>
+	struct is_xy : std::integral_constant<bool, !std::is_same<T, Self>::value && !is_kit_type<T>::value &&
+		has_x<T>::value && has_y<T>::value && !has_z<T>::value> {};
+
+	template<typename T, typename Self>
+	struct is_xyz : std::integral_constant<bool, !std::is_same<T, Self>::value && !is_kit_type<T>::value &&
+		has_x<T>::value && has_y<T>::value && has_z<T>::value && !has_w<T>::value> {};
+
+	template<typename T, typename Self>
+	struct is_xyzw : std::integral_constant<bool, !std::is_same<T, Self>::value && !is_kit_type<T>::value &&
+		has_x<T>::value && has_y<T>::value && has_z<T>::value && has_w<T>::value> {};
+}
+
+//Kit types are memcpy'd, viewed as PhysX/DirectX types and bulk-converted,
+//so they must stay trivially copyable, standard layout and tightly packed
+#define ESGS_CHECK_LAYOUT(T, size) static_assert(std::is_trivially_copyable<T>::value && std::is_standard_layout<T>::value && \
+	sizeof(T) == (size), #T " must be trivially copyable, standard layout and " #size " bytes")
@@ -1,11 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <cstring>
 #include "Vector3D.h"
 #include "Vector4D.h"
-#include <PxPhysics.h>
-#include <PxPhysicsAPI.h>
-#include "DLL.h"
+#include "LayoutTraits.h"
+#include "ProfileCounters.h"
+#include "Export.h"
 
 class ESGS_EXPORT Matrix4x4
 {
@@ -18,26 +19,11 @@ public:
 		m_mat[3][3] = 1;
 	}
 
-	Matrix4x4(physx::PxMat44& mat)
+	//PxMat44 and other column0..column3 types. Rows are stored like PxMat44 columns, see PhysxInterop.h
+	template<typename M, typename std::enable_if<layout_traits::has_columns<M>::value && sizeof(M) == sizeof(float) * 16, int>::type = 0>
+	Matrix4x4(const M& mat)
 	{
-		setIdentity();
-		for (int i = 0; i < 4; i++)
-		{
-			for (int j = 0; j < 4; j++)
-				m_mat[i][j] = mat[i][j];
-		}
-	}
-
-	physx::PxMat44 getPhysxMat44() 
-	{
-		physx::PxMat44 mat;
-		for (int i = 0; i < 4; i++)
-		{
-			for (int j = 0; j < 4; j++)
-				mat[i][j] = m_mat[i][j];
-		}
-
-		return mat;
+		::memcpy(m_mat, (const void*)&mat, sizeof(float) * 16);
 	}
 
 	void setIdentity()
@@ -72,6 +58,7 @@ public:
 
 	void inverse()
 	{
+		ESGS_COUNT(MatrixInverse, 1);
 		int a, i, j;
 		Matrix4x4 out;
 		Vector4D v, vec[3];
@@ -108,6 +95,7 @@ public:
 
 	void operator *=(const Matrix4x4& matrix)
 	{
+		ESGS_COUNT(MatrixMultiply, 1);
 		Matrix4x4 out;
 		for (int i = 0; i < 4; i++)
 		{
@@ -165,10 +153,9 @@ public:
 		m_mat[3][2] = -(near_plane / (far_plane - near_plane));
 	}
 
-	~Matrix4x4()
-	{
-	}
-
 public:
 	float m_mat[4][4] = {};
 };
+
+
+ESGS_CHECK_LAYOUT(Matrix4x4, sizeof(float) * 16);
\ No newline at end of file
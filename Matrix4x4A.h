@@ -0,0 +1,34 @@
+#pragma once
+#include "Matrix4x4.h"
+#include "LayoutTraits.h"
+#include "Simd.h"
+#include "Export.h"
+
+//16-byte aligned Matrix4x4, every row can be loaded with an aligned SSE load.
+//Matrix4x4 itself keeps 4-byte alignment so it can still view PxMat44 arrays.
+class ESGS_EXPORT alignas(16) Matrix4x4A : public Matrix4x4
+{
+public:
+	Matrix4x4A()
+	{
+	}
+
+	Matrix4x4A(const Matrix4x4& matrix) : Matrix4x4(matrix)
+	{
+	}
+
+#ifdef ESGS_SSE2
+	__m128 loadRow(int row) const
+	{
+		return _mm_load_ps(m_mat[row]);
+	}
+
+	void storeRow(int row, __m128 v)
+	{
+		_mm_store_ps(m_mat[row], v);
+	}
+#endif
+};
+
+ESGS_CHECK_LAYOUT(Matrix4x4A, sizeof(float) * 16);
+static_assert(alignof(Matrix4x4A) == 16, "Matrix4x4A must be 16-byte aligned");
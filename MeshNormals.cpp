@@ -0,0 +1,263 @@
+#include "MeshNormals.h"
+#include "AsyncCore.h"
+#include <cfloat>
+#include <cmath>
+
+//Work items per task, keeps small meshes on the calling thread
+#define MESH_PARALLEL_CHUNK 4096
+
+static inline void sub3(const Vector3D& a, const Vector3D& b, float out[3])
+{
+    out[0] = a.x - b.x;
+    out[1] = a.y - b.y;
+    out[2] = a.z - b.z;
+}
+
+static inline void cross3(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static inline float dot3(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//Scales to unit length, zero vectors stay zero. Not epsilon based: cross products of
+//small but valid triangles are tiny and must still normalize.
+static inline float normalize3(float v[3])
+{
+    float sq = dot3(v, v);
+    float len = sqrtf(sq);
+    float inv = sq >= FLT_MIN ? 1.0f / len : 0.0f;
+    v[0] *= inv;
+    v[1] *= inv;
+    v[2] *= inv;
+    return len;
+}
+
+//Angle between two edges leaving a corner, atan2 stays accurate for slivers
+static inline float cornerAngle(const float a[3], const float b[3])
+{
+    float c[3];
+    cross3(a, b, c);
+    return atan2f(sqrtf(dot3(c, c)), dot3(a, b));
+}
+
+template<typename T>
+static void run(size_t count, bool parallel, T body)
+{
+    if (parallel)
+        __parallel_for(count, MESH_PARALLEL_CHUNK, body);
+    else
+        body((size_t)0, count);
+}
+
+bool MeshNormals::setTopology(const uint32_t* indices, size_t triangleCount, size_t vertexCount)
+{
+    size_t cornerCount = triangleCount * 3;
+    for (size_t i = 0; i < cornerCount; i++)
+    {
+        if (indices[i] >= vertexCount)
+            return false;
+    }
+
+    m_indices.assign(indices, indices + cornerCount);
+    m_vertex_count = vertexCount;
+
+    //Counting sort of corners by vertex
+    m_corner_offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < cornerCount; i++)
+        m_corner_offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        m_corner_offsets[v + 1] += m_corner_offsets[v];
+
+    m_corners.resize(cornerCount);
+    std::vector<uint32_t> cursor(m_corner_offsets.begin(), m_corner_offsets.end() - 1);
+    for (size_t i = 0; i < cornerCount; i++)
+        m_corners[cursor[indices[i]]++] = (uint32_t)i;
+
+    m_corner_values.resize(cornerCount);
+    return true;
+}
+
+void MeshNormals::computeFaceNormals(const Vector3D* positions, Vector3D* faceNormals, bool parallel) const
+{
+    const uint32_t* indices = m_indices.data();
+    run(getTriangleCount(), parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            float e1[3], e2[3], n[3];
+            sub3(positions[tri[1]], positions[tri[0]], e1);
+            sub3(positions[tri[2]], positions[tri[0]], e2);
+            cross3(e1, e2, n);
+            normalize3(n);
+            faceNormals[t] = Vector3D(n[0], n[1], n[2]);
+        }
+    });
+}
+
+void MeshNormals::computeVertexNormals(const Vector3D* positions, NormalWeighting weighting, Vector3D* normals, bool parallel)
+{
+    const uint32_t* indices = m_indices.data();
+    Vector3D* values = m_corner_values.data();
+    run(getTriangleCount(), parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            float e01[3], e02[3], e12[3], n[3];
+            sub3(positions[tri[1]], positions[tri[0]], e01);
+            sub3(positions[tri[2]], positions[tri[0]], e02);
+            sub3(positions[tri[2]], positions[tri[1]], e12);
+
+            //|cross| is twice the area, so the raw cross product is the area weighted normal
+            cross3(e01, e02, n);
+            if (weighting == NormalWeighting::Area)
+            {
+                for (int k = 0; k < 3; k++)
+                    values[t * 3 + k] = Vector3D(n[0], n[1], n[2]);
+                continue;
+            }
+
+            normalize3(n);
+            float weights[3] = { 1.0f, 1.0f, 1.0f };
+            if (weighting == NormalWeighting::Angle)
+            {
+                float e10[3] = { -e01[0], -e01[1], -e01[2] };
+                float e20[3] = { -e02[0], -e02[1], -e02[2] };
+                float e21[3] = { -e12[0], -e12[1], -e12[2] };
+                weights[0] = cornerAngle(e01, e02);
+                weights[1] = cornerAngle(e12, e10);
+                weights[2] = cornerAngle(e20, e21);
+            }
+            for (int k = 0; k < 3; k++)
+                values[t * 3 + k] = Vector3D(n[0] * weights[k], n[1] * weights[k], n[2] * weights[k]);
+        }
+    });
+
+    const uint32_t* offsets = m_corner_offsets.data();
+    const uint32_t* corners = m_corners.data();
+    run(m_vertex_count, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; v++)
+        {
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            for (uint32_t c = offsets[v]; c < offsets[v + 1]; c++)
+            {
+                const Vector3D& value = values[corners[c]];
+                sum[0] += value.x;
+                sum[1] += value.y;
+                sum[2] += value.z;
+            }
+            normalize3(sum);
+            normals[v] = Vector3D(sum[0], sum[1], sum[2]);
+        }
+    });
+}
+
+void MeshNormals::computeTangents(const Vector3D* positions, const Vector3D* normals, const Vector2D* uvs,
+    Vector4D* tangents, bool parallel)
+{
+    m_corner_bitangents.resize(m_corner_values.size());
+    const uint32_t* indices = m_indices.data();
+    Vector3D* values = m_corner_values.data();
+    Vector3D* bitangents = m_corner_bitangents.data();
+    run(getTriangleCount(), parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            float e01[3], e02[3];
+            sub3(positions[tri[1]], positions[tri[0]], e01);
+            sub3(positions[tri[2]], positions[tri[0]], e02);
+            float du1 = uvs[tri[1]].x - uvs[tri[0]].x, dv1 = uvs[tri[1]].y - uvs[tri[0]].y;
+            float du2 = uvs[tri[2]].x - uvs[tri[0]].x, dv2 = uvs[tri[2]].y - uvs[tri[0]].y;
+
+            //Solve e01 = du1 T + dv1 B, e02 = du2 T + dv2 B; the sign of the UV area
+            //carries the mirroring, its magnitude cancels in the normalization
+            float det = du1 * dv2 - du2 * dv1;
+            float sign = det < 0.0f ? -1.0f : 1.0f;
+            float faceT[3], faceB[3];
+            for (int i = 0; i < 3; i++)
+            {
+                faceT[i] = (e01[i] * dv2 - e02[i] * dv1) * sign;
+                faceB[i] = (e02[i] * du1 - e01[i] * du2) * sign;
+            }
+            bool degenerate = fabsf(det) <= 1e-20f;
+
+            for (int k = 0; k < 3; k++)
+            {
+                size_t corner = t * 3 + k;
+                if (degenerate)
+                {
+                    values[corner] = Vector3D();
+                    bitangents[corner] = Vector3D();
+                    continue;
+                }
+
+                //Project onto the vertex normal's plane, then weight by the corner angle
+                const Vector3D& normal = normals[tri[k]];
+                float n[3] = { normal.x, normal.y, normal.z };
+                float pt[3], pb[3];
+                float dt = dot3(n, faceT), db = dot3(n, faceB);
+                for (int i = 0; i < 3; i++)
+                {
+                    pt[i] = faceT[i] - n[i] * dt;
+                    pb[i] = faceB[i] - n[i] * db;
+                }
+                normalize3(pt);
+                normalize3(pb);
+
+                float a[3], b[3];
+                sub3(positions[tri[(k + 1) % 3]], positions[tri[k]], a);
+                sub3(positions[tri[(k + 2) % 3]], positions[tri[k]], b);
+                float w = cornerAngle(a, b);
+                values[corner] = Vector3D(pt[0] * w, pt[1] * w, pt[2] * w);
+                bitangents[corner] = Vector3D(pb[0] * w, pb[1] * w, pb[2] * w);
+            }
+        }
+    });
+
+    const uint32_t* offsets = m_corner_offsets.data();
+    const uint32_t* corners = m_corners.data();
+    run(m_vertex_count, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; v++)
+        {
+            float st[3] = { 0.0f, 0.0f, 0.0f };
+            float sb[3] = { 0.0f, 0.0f, 0.0f };
+            for (uint32_t c = offsets[v]; c < offsets[v + 1]; c++)
+            {
+                const Vector3D& ct = values[corners[c]];
+                const Vector3D& cb = bitangents[corners[c]];
+                st[0] += ct.x;
+                st[1] += ct.y;
+                st[2] += ct.z;
+                sb[0] += cb.x;
+                sb[1] += cb.y;
+                sb[2] += cb.z;
+            }
+
+            float n[3] = { normals[v].x, normals[v].y, normals[v].z };
+            if (normalize3(st) == 0.0f)
+            {
+                //No usable UVs around this vertex, any tangent perpendicular to the normal
+                float axis[3] = { fabsf(n[0]) < 0.9f ? 1.0f : 0.0f, fabsf(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+                float d = dot3(axis, n);
+                for (int i = 0; i < 3; i++)
+                    st[i] = axis[i] - n[i] * d;
+                normalize3(st);
+            }
+
+            float nt[3];
+            cross3(n, st, nt);
+            float w = dot3(nt, sb) < 0.0f ? -1.0f : 1.0f;
+            tangents[v] = Vector4D(st[0], st[1], st[2], w);
+        }
+    });
+}
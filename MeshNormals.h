@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Export.h"
+
+enum class NormalWeighting : uint8_t
+{
+	//Every adjacent face counts the same
+	Uniform,
+	//Weighted by face area, large faces dominate
+	Area,
+	//Weighted by the face's corner angle at the vertex, independent of tessellation
+	Angle
+};
+
+//Per-vertex normals and tangents for indexed triangle lists. setTopology() builds a
+//vertex to face-corner table once; the compute passes run per triangle and then per
+//vertex in parallel, each vertex gathers its own corners, so nothing is accumulated
+//through shared writes or locks. For deforming meshes set the topology once and call
+//the compute passes every frame.
+class ESGS_EXPORT MeshNormals
+{
+public:
+	MeshNormals()
+	{
+	}
+
+	//Three indices per triangle. Returns false if an index is not below vertexCount.
+	bool setTopology(const uint32_t* indices, size_t triangleCount, size_t vertexCount);
+
+	size_t getTriangleCount() const { return m_indices.size() / 3; }
+	size_t getVertexCount() const { return m_vertex_count; }
+
+	//One unit normal per triangle, zero for degenerate triangles
+	void computeFaceNormals(const Vector3D* positions, Vector3D* faceNormals, bool parallel = true) const;
+
+	void computeVertexNormals(const Vector3D* positions, NormalWeighting weighting, Vector3D* normals, bool parallel = true);
+
+	//MikkTSpace convention: per-corner tangents are projected onto the vertex normal's
+	//plane and angle weighted, w is the sign with bitangent = w * cross(normal, tangent).
+	//Vertices are not split, so index buffers must already separate UV seams and mirrors.
+	void computeTangents(const Vector3D* positions, const Vector3D* normals, const Vector2D* uvs,
+		Vector4D* tangents, bool parallel = true);
+
+private:
+	std::vector<uint32_t> m_indices;
+	size_t m_vertex_count = 0;
+
+	//Corners (triangle * 3 + k) of vertex v are m_corners[m_corner_offsets[v] .. m_corner_offsets[v + 1])
+	std::vector<uint32_t> m_corner_offsets;
+	std::vector<uint32_t> m_corners;
+
+	//Per-corner contributions, written per triangle and gathered per vertex
+	std::vector<Vector3D> m_corner_values;
+	std::vector<Vector3D> m_corner_bitangents;
+};
@@ -0,0 +1,651 @@
+#include "NarrowPhase.h"
+#include "AsyncCore.h"
+#include "Simd.h"
+#include <cmath>
+#include <limits>
+
+//Pairs per task
+#define NARROWPHASE_PARALLEL_CHUNK 2048
+
+namespace
+{
+    struct ScalarLane
+    {
+        typedef float F;
+        typedef bool M;
+        enum { width = 1 };
+
+        static F set(float v) { return v; }
+        static F gather(const float* base, const uint32_t* index) { return base[index[0]]; }
+        static void store(float* p, F v) { *p = v; }
+        static void storeMask(uint8_t* p, M m) { *p = m ? 1 : 0; }
+
+        static F add(F a, F b) { return a + b; }
+        static F sub(F a, F b) { return a - b; }
+        static F mul(F a, F b) { return a * b; }
+        static F div(F a, F b) { return a / b; }
+        static F min(F a, F b) { return a < b ? a : b; }
+        static F max(F a, F b) { return a > b ? a : b; }
+        static F sqrt(F a) { return sqrtf(a); }
+        static F abs(F a) { return fabsf(a); }
+
+        static M lt(F a, F b) { return a < b; }
+        static M gt(F a, F b) { return a > b; }
+        static M le(F a, F b) { return a <= b; }
+        static F select(M m, F a, F b) { return m ? a : b; }
+        static M mor(M a, M b) { return a || b; }
+        static M mnot(M m) { return !m; }
+    };
+
+#ifdef ESGS_SSE2
+    struct SseLane
+    {
+        typedef __m128 F;
+        typedef __m128 M;
+        enum { width = 4 };
+
+        static F set(float v) { return _mm_set1_ps(v); }
+        static F gather(const float* base, const uint32_t* index)
+        {
+            return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+        }
+        static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+        static void storeMask(uint8_t* p, M m)
+        {
+            int bits = _mm_movemask_ps(m);
+            for (int k = 0; k < 4; k++)
+                p[k] = (uint8_t)((bits >> k) & 1);
+        }
+
+        static F add(F a, F b) { return _mm_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F div(F a, F b) { return _mm_div_ps(a, b); }
+        //Same operand order as the scalar ternaries, so NaN lanes agree
+        static F min(F a, F b) { return _mm_min_ps(a, b); }
+        static F max(F a, F b) { return _mm_max_ps(a, b); }
+        static F sqrt(F a) { return _mm_sqrt_ps(a); }
+        static F abs(F a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+
+        static M lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+        static M gt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+        static M le(F a, F b) { return _mm_cmple_ps(a, b); }
+        static F select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        static M mor(M a, M b) { return _mm_or_ps(a, b); }
+        static M mnot(M m) { return _mm_xor_ps(m, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    };
+#endif
+
+    template<typename L>
+    struct Vec
+    {
+        typename L::F x, y, z;
+    };
+}
+
+template<typename L>
+static Vec<L> gatherVec(const float* x, const float* y, const float* z, const uint32_t* index)
+{
+    return Vec<L>{ L::gather(x, index), L::gather(y, index), L::gather(z, index) };
+}
+
+template<typename L>
+static Vec<L> subVec(const Vec<L>& a, const Vec<L>& b)
+{
+    return Vec<L>{ L::sub(a.x, b.x), L::sub(a.y, b.y), L::sub(a.z, b.z) };
+}
+
+template<typename L>
+static Vec<L> madVec(const Vec<L>& a, const Vec<L>& d, typename L::F t)
+{
+    return Vec<L>{ L::add(a.x, L::mul(d.x, t)), L::add(a.y, L::mul(d.y, t)), L::add(a.z, L::mul(d.z, t)) };
+}
+
+template<typename L>
+static typename L::F dotVec(const Vec<L>& a, const Vec<L>& b)
+{
+    return L::add(L::add(L::mul(a.x, b.x), L::mul(a.y, b.y)), L::mul(a.z, b.z));
+}
+
+template<typename L>
+static typename L::F clamp01(typename L::F v)
+{
+    return L::min(L::max(v, L::set(0.0f)), L::set(1.0f));
+}
+
+//Signed surface distance of two spheres (or swept points) given their centers
+template<typename L>
+static typename L::F surfaceDistance(const Vec<L>& a, const Vec<L>& b, typename L::F radiusA, typename L::F radiusB)
+{
+    Vec<L> d = subVec<L>(a, b);
+    return L::sub(L::sqrt(dotVec<L>(d, d)), L::add(radiusA, radiusB));
+}
+
+//Parameter of the point on segment a + d t closest to p, zero length segments give 0
+template<typename L>
+static typename L::F closestOnSegment(const Vec<L>& a, const Vec<L>& d, const Vec<L>& p)
+{
+    typename L::F dd = dotVec<L>(d, d);
+    typename L::F t = L::div(dotVec<L>(subVec<L>(p, a), d), L::max(dd, L::set(1e-30f)));
+    return L::select(L::gt(dd, L::set(1e-12f)), clamp01<L>(t), L::set(0.0f));
+}
+
+struct SphereSphereKernel
+{
+    const SphereShapes& a;
+    const SphereShapes& b;
+
+    template<typename L>
+    typename L::F distance(const uint32_t* ia, const uint32_t* ib) const
+    {
+        Vec<L> ca = gatherVec<L>(a.x, a.y, a.z, ia);
+        Vec<L> cb = gatherVec<L>(b.x, b.y, b.z, ib);
+        return surfaceDistance<L>(ca, cb, L::gather(a.radius, ia), L::gather(b.radius, ib));
+    }
+};
+
+struct SphereCapsuleKernel
+{
+    const SphereShapes& a;
+    const CapsuleShapes& b;
+
+    template<typename L>
+    typename L::F distance(const uint32_t* ia, const uint32_t* ib) const
+    {
+        Vec<L> center = gatherVec<L>(a.x, a.y, a.z, ia);
+        Vec<L> p = gatherVec<L>(b.ax, b.ay, b.az, ib);
+        Vec<L> d = subVec<L>(gatherVec<L>(b.bx, b.by, b.bz, ib), p);
+        Vec<L> closest = madVec<L>(p, d, closestOnSegment<L>(p, d, center));
+        return surfaceDistance<L>(center, closest, L::gather(a.radius, ia), L::gather(b.radius, ib));
+    }
+};
+
+//Closest points of two segments (Ericson, Real-Time Collision Detection 5.1.9) with the
+//branches turned into selects
+struct CapsuleCapsuleKernel
+{
+    const CapsuleShapes& a;
+    const CapsuleShapes& b;
+
+    template<typename L>
+    typename L::F distance(const uint32_t* ia, const uint32_t* ib) const
+    {
+        typedef typename L::F F;
+        Vec<L> p1 = gatherVec<L>(a.ax, a.ay, a.az, ia);
+        Vec<L> d1 = subVec<L>(gatherVec<L>(a.bx, a.by, a.bz, ia), p1);
+        Vec<L> p2 = gatherVec<L>(b.ax, b.ay, b.az, ib);
+        Vec<L> d2 = subVec<L>(gatherVec<L>(b.bx, b.by, b.bz, ib), p2);
+        Vec<L> r = subVec<L>(p1, p2);
+
+        F zero = L::set(0.0f);
+        F tiny = L::set(1e-30f);
+        F degenerate = L::set(1e-12f);
+        F aa = dotVec<L>(d1, d1);
+        F e = dotVec<L>(d2, d2);
+        F f = dotVec<L>(d2, r);
+        F c = dotVec<L>(d1, r);
+        F bb = dotVec<L>(d1, d2);
+        F safeA = L::max(aa, tiny);
+        F safeE = L::max(e, tiny);
+
+        //Parallel segments start from s = 0
+        F denom = L::sub(L::mul(aa, e), L::mul(bb, bb));
+        F s = L::select(L::gt(denom, L::mul(degenerate, L::mul(aa, e))),
+            clamp01<L>(L::div(L::sub(L::mul(bb, f), L::mul(c, e)), L::max(denom, tiny))), zero);
+        F t = L::div(L::add(L::mul(bb, s), f), safeE);
+
+        //Re-clamp s where t left [0, 1]
+        F sLow = clamp01<L>(L::div(L::sub(zero, c), safeA));
+        F sHigh = clamp01<L>(L::div(L::sub(bb, c), safeA));
+        s = L::select(L::lt(t, zero), sLow, L::select(L::gt(t, L::set(1.0f)), sHigh, s));
+        t = clamp01<L>(t);
+
+        //Point-like segments
+        typename L::M pointB = L::le(e, degenerate);
+        s = L::select(pointB, sLow, s);
+        t = L::select(pointB, zero, t);
+        typename L::M pointA = L::le(aa, degenerate);
+        s = L::select(pointA, zero, s);
+        t = L::select(pointA, clamp01<L>(L::div(f, safeE)), t);
+
+        Vec<L> c1 = madVec<L>(p1, d1, s);
+        Vec<L> c2 = madVec<L>(p2, d2, t);
+        return surfaceDistance<L>(c1, c2, L::gather(a.radius, ia), L::gather(b.radius, ib));
+    }
+};
+
+template<typename L>
+static void boxAxes(const BoxShapes& box, const uint32_t* index, Vec<L> axes[3])
+{
+    typedef typename L::F F;
+    F x = L::gather(box.qx, index), y = L::gather(box.qy, index);
+    F z = L::gather(box.qz, index), w = L::gather(box.qw, index);
+    F one = L::set(1.0f), two = L::set(2.0f);
+    F xx = L::mul(x, x), yy = L::mul(y, y), zz = L::mul(z, z);
+    F xy = L::mul(x, y), xz = L::mul(x, z), yz = L::mul(y, z);
+    F wx = L::mul(w, x), wy = L::mul(w, y), wz = L::mul(w, z);
+
+    axes[0] = Vec<L>{ L::sub(one, L::mul(two, L::add(yy, zz))), L::mul(two, L::add(xy, wz)), L::mul(two, L::sub(xz, wy)) };
+    axes[1] = Vec<L>{ L::mul(two, L::sub(xy, wz)), L::sub(one, L::mul(two, L::add(xx, zz))), L::mul(two, L::add(yz, wx)) };
+    axes[2] = Vec<L>{ L::mul(two, L::add(xz, wy)), L::mul(two, L::sub(yz, wx)), L::sub(one, L::mul(two, L::add(xx, yy))) };
+}
+
+//OBB separating axis test (Ericson 4.4.1), separated lanes are ORed over all 15 axes
+struct BoxBoxKernel
+{
+    const BoxShapes& a;
+    const BoxShapes& b;
+
+    template<typename L>
+    typename L::M overlap(const uint32_t* ia, const uint32_t* ib) const
+    {
+        typedef typename L::F F;
+        Vec<L> axesA[3], axesB[3];
+        boxAxes<L>(a, ia, axesA);
+        boxAxes<L>(b, ib, axesB);
+        F ea[3] = { L::gather(a.halfX, ia), L::gather(a.halfY, ia), L::gather(a.halfZ, ia) };
+        F eb[3] = { L::gather(b.halfX, ib), L::gather(b.halfY, ib), L::gather(b.halfZ, ib) };
+        Vec<L> d = subVec<L>(gatherVec<L>(b.x, b.y, b.z, ib), gatherVec<L>(a.x, a.y, a.z, ia));
+
+        //Rotation of b in a's frame, the epsilon keeps near parallel edge pairs from
+        //producing a zero cross product axis that reports false separation
+        F rot[3][3], absRot[3][3], t[3];
+        F guard = L::set(1e-6f);
+        for (int i = 0; i < 3; i++)
+        {
+            t[i] = dotVec<L>(d, axesA[i]);
+            for (int j = 0; j < 3; j++)
+            {
+                rot[i][j] = dotVec<L>(axesA[i], axesB[j]);
+                absRot[i][j] = L::add(L::abs(rot[i][j]), guard);
+            }
+        }
+
+        typename L::M separated = L::lt(L::set(1.0f), L::set(0.0f));
+        for (int i = 0; i < 3; i++)
+        {
+            F rb = L::add(L::add(L::mul(eb[0], absRot[i][0]), L::mul(eb[1], absRot[i][1])), L::mul(eb[2], absRot[i][2]));
+            separated = L::mor(separated, L::gt(L::abs(t[i]), L::add(ea[i], rb)));
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            F ra = L::add(L::add(L::mul(ea[0], absRot[0][j]), L::mul(ea[1], absRot[1][j])), L::mul(ea[2], absRot[2][j]));
+            F proj = L::add(L::add(L::mul(t[0], rot[0][j]), L::mul(t[1], rot[1][j])), L::mul(t[2], rot[2][j]));
+            separated = L::mor(separated, L::gt(L::abs(proj), L::add(ra, eb[j])));
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; j++)
+            {
+                int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                F ra = L::add(L::mul(ea[i1], absRot[i2][j]), L::mul(ea[i2], absRot[i1][j]));
+                F rb = L::add(L::mul(eb[j1], absRot[i][j2]), L::mul(eb[j2], absRot[i][j1]));
+                F proj = L::sub(L::mul(t[i2], rot[i1][j]), L::mul(t[i1], rot[i2][j]));
+                separated = L::mor(separated, L::gt(L::abs(proj), L::add(ra, rb)));
+            }
+        }
+        return L::mnot(separated);
+    }
+};
+
+template<typename L, typename Kernel>
+static void distanceLanes(const Kernel& kernel, const uint32_t* ia, const uint32_t* ib, uint8_t* hits, float* distances)
+{
+    typename L::F distance = kernel.template distance<L>(ia, ib);
+    L::storeMask(hits, L::le(distance, L::set(0.0f)));
+    if (distances)
+        L::store(distances, distance);
+}
+
+template<typename L, typename Kernel>
+static void overlapLanes(const Kernel& kernel, const uint32_t* ia, const uint32_t* ib, uint8_t* hits, float*)
+{
+    L::storeMask(hits, kernel.template overlap<L>(ia, ib));
+}
+
+//Splits the pair list into tasks and feeds four pairs at a time to the SSE2 lanes
+template<typename Kernel,
+    void (*Sse)(const Kernel&, const uint32_t*, const uint32_t*, uint8_t*, float*),
+    void (*Scalar)(const Kernel&, const uint32_t*, const uint32_t*, uint8_t*, float*)>
+static size_t runPairs(const Kernel& kernel, const ShapePair* pairs, size_t count, uint8_t* hits, float* distances, bool parallel)
+{
+    auto body = [&](size_t begin, size_t end)
+    {
+        size_t i = begin;
+#ifdef ESGS_SSE2
+        for (; i + 4 <= end; i += 4)
+        {
+            uint32_t ia[4] = { pairs[i].a, pairs[i + 1].a, pairs[i + 2].a, pairs[i + 3].a };
+            uint32_t ib[4] = { pairs[i].b, pairs[i + 1].b, pairs[i + 2].b, pairs[i + 3].b };
+            Sse(kernel, ia, ib, hits + i, distances ? distances + i : nullptr);
+        }
+#endif
+        for (; i < end; i++)
+            Scalar(kernel, &pairs[i].a, &pairs[i].b, hits + i, distances ? distances + i : nullptr);
+    };
+
+    if (parallel)
+        __parallel_for(count, NARROWPHASE_PARALLEL_CHUNK, body);
+    else
+        body(0, count);
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += hits[i];
+    return total;
+}
+
+#ifdef ESGS_SSE2
+#define NARROWPHASE_LANES(kernel, lanes) runPairs<kernel, lanes<SseLane, kernel>, lanes<ScalarLane, kernel>>
+#else
+#define NARROWPHASE_LANES(kernel, lanes) runPairs<kernel, lanes<ScalarLane, kernel>, lanes<ScalarLane, kernel>>
+#endif
+
+size_t NarrowPhase::sphereSphere(const SphereShapes& a, const SphereShapes& b, const ShapePair* pairs, size_t count,
+    uint8_t* hits, float* distances, bool parallel)
+{
+    SphereSphereKernel kernel{ a, b };
+    return NARROWPHASE_LANES(SphereSphereKernel, distanceLanes)(kernel, pairs, count, hits, distances, parallel);
+}
+
+size_t NarrowPhase::sphereCapsule(const SphereShapes& a, const CapsuleShapes& b, const ShapePair* pairs, size_t count,
+    uint8_t* hits, float* distances, bool parallel)
+{
+    SphereCapsuleKernel kernel{ a, b };
+    return NARROWPHASE_LANES(SphereCapsuleKernel, distanceLanes)(kernel, pairs, count, hits, distances, parallel);
+}
+
+size_t NarrowPhase::capsuleCapsule(const CapsuleShapes& a, const CapsuleShapes& b, const ShapePair* pairs, size_t count,
+    uint8_t* hits, float* distances, bool parallel)
+{
+    CapsuleCapsuleKernel kernel{ a, b };
+    return NARROWPHASE_LANES(CapsuleCapsuleKernel, distanceLanes)(kernel, pairs, count, hits, distances, parallel);
+}
+
+size_t NarrowPhase::boxBox(const BoxShapes& a, const BoxShapes& b, const ShapePair* pairs, size_t count,
+    uint8_t* hits, bool parallel)
+{
+    BoxBoxKernel kernel{ a, b };
+    return NARROWPHASE_LANES(BoxBoxKernel, overlapLanes)(kernel, pairs, count, hits, nullptr, parallel);
+}
+
+namespace
+{
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    inline Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+    inline Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+    inline Vec3 operator*(const Vec3& a, float s) { return Vec3{ a.x * s, a.y * s, a.z * s }; }
+    inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline Vec3 cross(const Vec3& a, const Vec3& b)
+    {
+        return Vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    //Minkowski difference vertex w = a - b with the shape points it came from
+    struct SimplexVertex
+    {
+        Vec3 w;
+        Vec3 a;
+        Vec3 b;
+    };
+
+    struct Simplex
+    {
+        SimplexVertex v[4];
+        float weight[4];
+        int count = 0;
+    };
+}
+
+static Vec3 support(const ConvexShape& shape, const Vec3& direction)
+{
+    const Vector3D* best = &shape.points[0];
+    float bestDot = best->x * direction.x + best->y * direction.y + best->z * direction.z;
+    for (size_t i = 1; i < shape.count; i++)
+    {
+        const Vector3D& p = shape.points[i];
+        float d = p.x * direction.x + p.y * direction.y + p.z * direction.z;
+        if (d > bestDot)
+        {
+            bestDot = d;
+            best = &p;
+        }
+    }
+    return Vec3{ best->x, best->y, best->z };
+}
+
+static void keep(Simplex& s, int i0, float w0)
+{
+    s.v[0] = s.v[i0];
+    s.weight[0] = w0;
+    s.count = 1;
+}
+
+static void keep(Simplex& s, int i0, float w0, int i1, float w1)
+{
+    SimplexVertex a = s.v[i0], b = s.v[i1];
+    s.v[0] = a;
+    s.v[1] = b;
+    s.weight[0] = w0;
+    s.weight[1] = w1;
+    s.count = 2;
+}
+
+static void solveSegment(Simplex& s)
+{
+    Vec3 a = s.v[0].w, ab = s.v[1].w - s.v[0].w;
+    float t = -dot(a, ab) / dot(ab, ab);
+    if (!(t > 0.0f))
+        keep(s, 0, 1.0f);
+    else if (t >= 1.0f)
+        keep(s, 1, 1.0f);
+    else
+        keep(s, 0, 1.0f - t, 1, t);
+}
+
+//Closest point of triangle (s.v[i0], s.v[i1], s.v[i2]) to the origin (Ericson 5.1.5),
+//the simplex is reduced to the supporting feature
+static void solveTriangle(Simplex& s, int i0, int i1, int i2)
+{
+    Vec3 a = s.v[i0].w, b = s.v[i1].w, c = s.v[i2].w;
+    Vec3 ab = b - a, ac = c - a;
+
+    float d1 = -dot(ab, a), d2 = -dot(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return keep(s, i0, 1.0f);
+
+    float d3 = -dot(ab, b), d4 = -dot(ac, b);
+    if (d3 >= 0.0f && d4 <= d3)
+        return keep(s, i1, 1.0f);
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        float v = d1 / (d1 - d3);
+        return keep(s, i0, 1.0f - v, i1, v);
+    }
+
+    float d5 = -dot(ab, c), d6 = -dot(ac, c);
+    if (d6 >= 0.0f && d5 <= d6)
+        return keep(s, i2, 1.0f);
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        float w = d2 / (d2 - d6);
+        return keep(s, i0, 1.0f - w, i2, w);
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return keep(s, i1, 1.0f - w, i2, w);
+    }
+
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom, w = vc * denom;
+    SimplexVertex A = s.v[i0], B = s.v[i1], C = s.v[i2];
+    s.v[0] = A;
+    s.v[1] = B;
+    s.v[2] = C;
+    s.weight[0] = 1.0f - v - w;
+    s.weight[1] = v;
+    s.weight[2] = w;
+    s.count = 3;
+}
+
+static Vec3 closestPoint(const Simplex& s)
+{
+    Vec3 p{ 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < s.count; i++)
+        p = p + s.v[i].w * s.weight[i];
+    return p;
+}
+
+//Returns false when the origin is inside the tetrahedron
+static bool solveTetrahedron(Simplex& s)
+{
+    static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+
+    Simplex best;
+    float bestDistance = std::numeric_limits<float>::infinity();
+    bool outside = false;
+    for (int f = 0; f < 4; f++)
+    {
+        Vec3 a = s.v[faces[f][0]].w;
+        Vec3 n = cross(s.v[faces[f][1]].w - a, s.v[faces[f][2]].w - a);
+        float sideOrigin = -dot(a, n);
+        float sideOpposite = dot(s.v[faces[f][3]].w - a, n);
+        //Flat tetrahedra test every face
+        bool degenerate = fabsf(sideOpposite) <= 1e-12f * dot(n, n);
+        if (!degenerate && sideOrigin * sideOpposite >= 0.0f)
+            continue;
+
+        outside = true;
+        Simplex candidate = s;
+        solveTriangle(candidate, faces[f][0], faces[f][1], faces[f][2]);
+        Vec3 p = closestPoint(candidate);
+        float distance = dot(p, p);
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = candidate;
+        }
+    }
+
+    if (outside)
+        s = best;
+    return outside;
+}
+
+GjkResult NarrowPhase::gjkDistance(const ConvexShape& a, const ConvexShape& b, uint32_t maxIterations)
+{
+    GjkResult result;
+    if (a.count == 0 || b.count == 0)
+    {
+        result.distance = std::numeric_limits<float>::infinity();
+        return result;
+    }
+
+    Simplex simplex;
+    Vec3 pa{ a.points[0].x, a.points[0].y, a.points[0].z };
+    Vec3 pb{ b.points[0].x, b.points[0].y, b.points[0].z };
+    simplex.v[0] = SimplexVertex{ pa - pb, pa, pb };
+    simplex.weight[0] = 1.0f;
+    simplex.count = 1;
+    Vec3 v = pa - pb;
+
+    const float relativeTolerance = 1e-6f;
+    const float absoluteTolerance = 1e-12f;
+    while (result.iterations < maxIterations)
+    {
+        result.iterations++;
+        float vv = dot(v, v);
+        if (vv <= absoluteTolerance)
+        {
+            result.overlapping = true;
+            break;
+        }
+
+        Vec3 sa = support(a, v * -1.0f);
+        Vec3 sb = support(b, v);
+        Vec3 w = sa - sb;
+
+        //No progress towards the origin, v is the closest point of the difference
+        if (vv - dot(v, w) <= relativeTolerance * vv)
+            break;
+
+        bool duplicate = false;
+        for (int i = 0; i < simplex.count; i++)
+        {
+            Vec3 d = simplex.v[i].w - w;
+            duplicate = duplicate || dot(d, d) <= absoluteTolerance;
+        }
+        if (duplicate)
+            break;
+
+        simplex.v[simplex.count++] = SimplexVertex{ w, sa, sb };
+        if (simplex.count == 2)
+            solveSegment(simplex);
+        else if (simplex.count == 3)
+            solveTriangle(simplex, 0, 1, 2);
+        else if (!solveTetrahedron(simplex))
+        {
+            result.overlapping = true;
+            break;
+        }
+
+        Vec3 next = closestPoint(simplex);
+        //Rounding can stall the descent, keep the better point
+        if (dot(next, next) >= vv)
+            break;
+        v = next;
+    }
+
+    Vec3 closestA{ 0.0f, 0.0f, 0.0f }, closestB{ 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < simplex.count; i++)
+    {
+        closestA = closestA + simplex.v[i].a * simplex.weight[i];
+        closestB = closestB + simplex.v[i].b * simplex.weight[i];
+    }
+
+    float length = result.overlapping ? 0.0f : sqrtf(dot(v, v));
+    float distance = length - a.radius - b.radius;
+    if (distance <= 0.0f)
+    {
+        result.overlapping = true;
+        result.distance = 0.0f;
+    }
+    else
+    {
+        //Move the core witness points out to the inflated surfaces, v points from b to a
+        Vec3 n = v * (1.0f / length);
+        closestA = closestA - n * a.radius;
+        closestB = closestB + n * b.radius;
+        result.distance = distance;
+    }
+
+    result.pointA = Vector3D(closestA.x, closestA.y, closestA.z);
+    result.pointB = Vector3D(closestB.x, closestB.y, closestB.z);
+    return result;
+}
+
+void NarrowPhase::gjkDistance(const ConvexShape* shapes, const ShapePair* pairs, size_t count, float* distances, bool parallel)
+{
+    auto body = [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            distances[i] = gjkDistance(shapes[pairs[i].a], shapes[pairs[i].b]).distance;
+    };
+
+    if (parallel)
+        __parallel_for(count, NARROWPHASE_PARALLEL_CHUNK / 8, body);
+    else
+        body(0, count);
+}
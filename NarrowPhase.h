@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Vector3D.h"
+#include "Export.h"
+
+//World space shapes as structure of arrays, every array holds count entries
+struct SphereShapes
+{
+	const float* x = nullptr;
+	const float* y = nullptr;
+	const float* z = nullptr;
+	const float* radius = nullptr;
+
+	size_t count = 0;
+};
+
+//Segment from a to b swept by radius
+struct CapsuleShapes
+{
+	const float* ax = nullptr;
+	const float* ay = nullptr;
+	const float* az = nullptr;
+	const float* bx = nullptr;
+	const float* by = nullptr;
+	const float* bz = nullptr;
+	const float* radius = nullptr;
+
+	size_t count = 0;
+};
+
+//Oriented boxes: center, half extents along the local axes and a unit rotation
+struct BoxShapes
+{
+	const float* x = nullptr;
+	const float* y = nullptr;
+	const float* z = nullptr;
+	const float* halfX = nullptr;
+	const float* halfY = nullptr;
+	const float* halfZ = nullptr;
+	const float* qx = nullptr;
+	const float* qy = nullptr;
+	const float* qz = nullptr;
+	const float* qw = nullptr;
+
+	size_t count = 0;
+};
+
+//Candidate pair from the broad phase, a indexes the first shape set and b the second
+struct ShapePair
+{
+	uint32_t a = 0;
+	uint32_t b = 0;
+};
+
+//Convex hull of world space points inflated by radius: one point is a sphere, two a
+//capsule, eight box corners a (rounded) box
+struct ConvexShape
+{
+	const Vector3D* points = nullptr;
+	size_t count = 0;
+	float radius = 0.0f;
+};
+
+struct GjkResult
+{
+	//Distance between the inflated shapes, zero when they overlap
+	float distance = 0.0f;
+	//Closest points on either shape, meaningful when not overlapping
+	Vector3D pointA;
+	Vector3D pointB;
+	bool overlapping = false;
+	uint32_t iterations = 0;
+};
+
+//Narrow phase for gameplay overlap checks outside PhysX (hitboxes, triggers). Pair tests
+//gather four pairs into SSE2 registers, the scalar tail runs the same operations, and
+//large pair lists are split across cores. hits receives one byte per pair, distances (optional)
+//the signed distance between the surfaces, negative when penetrating. Returns the hit count.
+class ESGS_EXPORT NarrowPhase
+{
+public:
+	static size_t sphereSphere(const SphereShapes& a, const SphereShapes& b, const ShapePair* pairs, size_t count,
+		uint8_t* hits, float* distances = nullptr, bool parallel = true);
+
+	static size_t sphereCapsule(const SphereShapes& a, const CapsuleShapes& b, const ShapePair* pairs, size_t count,
+		uint8_t* hits, float* distances = nullptr, bool parallel = true);
+
+	static size_t capsuleCapsule(const CapsuleShapes& a, const CapsuleShapes& b, const ShapePair* pairs, size_t count,
+		uint8_t* hits, float* distances = nullptr, bool parallel = true);
+
+	//Separating axis test over the 15 candidate axes, overlap only
+	static size_t boxBox(const BoxShapes& a, const BoxShapes& b, const ShapePair* pairs, size_t count,
+		uint8_t* hits, bool parallel = true);
+
+	//Distance between two convex shapes, GJK with Johnson's closest point subalgorithm
+	static GjkResult gjkDistance(const ConvexShape& a, const ConvexShape& b, uint32_t maxIterations = 32);
+
+	//Pairs index one shape array, distances receives GjkResult::distance per pair
+	static void gjkDistance(const ConvexShape* shapes, const ShapePair* pairs, size_t count, float* distances,
+		bool parallel = true);
+};
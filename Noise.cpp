@@ -0,0 +1,580 @@
+#include "Noise.h"
+#include "AsyncCore.h"
+#include "ProfileCounters.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+#include <cmath>
+
+//Contraction would fuse the scalar lane into FMA but not the SSE2 one, and differently
+//per build, so the whole file keeps every multiply and add separately rounded
+ESGS_STRICT_FLOAT_BEGIN
+
+//Lane abstractions, every noise function is written once against these so the SSE2
+//batch path and the scalar path execute the same operations in the same order
+struct ScalarLane
+{
+    typedef float F;
+    typedef int32_t I;
+    typedef bool M;
+
+    static F set(float v) { return v; }
+    static I seti(int32_t v) { return v; }
+
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F neg(F a) { return 0.0f - a; }
+    static F max(F a, F b) { return a > b ? a : b; }
+    static F abs(F a) { return fabsf(a); }
+    static F floor(F x)
+    {
+        F t = (float)(int32_t)x;
+        return t > x ? t - 1.0f : t;
+    }
+
+    static M gt(F a, F b) { return a > b; }
+    static F select(M m, F a, F b) { return m ? a : b; }
+    static F maskToFloat(M m) { return m ? 1.0f : 0.0f; }
+
+    static I toInt(F x) { return (int32_t)x; }
+    static I addi(I a, I b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+    static I muli(I a, I b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+    static I xori(I a, I b) { return a ^ b; }
+    static I andi(I a, I b) { return a & b; }
+    static I srli(I a, int n) { return (int32_t)((uint32_t)a >> n); }
+    static M eqi(I a, I b) { return a == b; }
+    static M gti(I a, I b) { return a > b; }
+
+    static M mand(M a, M b) { return a && b; }
+    static M mor(M a, M b) { return a || b; }
+    static M mnot(M m) { return !m; }
+    static I maskBits(M m) { return m ? -1 : 0; }
+    static I maskToInt(M m) { return m ? 1 : 0; }
+};
+
+#ifdef ESGS_SSE2
+struct SseLane
+{
+    typedef __m128 F;
+    typedef __m128i I;
+    typedef __m128 M;
+
+    static F set(float v) { return _mm_set1_ps(v); }
+    static I seti(int32_t v) { return _mm_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F neg(F a) { return _mm_sub_ps(_mm_setzero_ps(), a); }
+    static F max(F a, F b) { return _mm_max_ps(a, b); }
+    static F abs(F a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+    static F floor(F x)
+    {
+        F t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+    }
+
+    static M gt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    static F select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static F maskToFloat(M m) { return _mm_and_ps(m, _mm_set1_ps(1.0f)); }
+
+    static I toInt(F x) { return _mm_cvttps_epi32(x); }
+    static I addi(I a, I b) { return _mm_add_epi32(a, b); }
+    //SSE2 has no 32-bit mullo, multiply even and odd lanes separately
+    static I muli(I a, I b)
+    {
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    static I xori(I a, I b) { return _mm_xor_si128(a, b); }
+    static I andi(I a, I b) { return _mm_and_si128(a, b); }
+    static I srli(I a, int n) { return _mm_srli_epi32(a, n); }
+    static M eqi(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static M gti(I a, I b) { return _mm_castsi128_ps(_mm_cmpgt_epi32(a, b)); }
+
+    static M mand(M a, M b) { return _mm_and_ps(a, b); }
+    static M mor(M a, M b) { return _mm_or_ps(a, b); }
+    static M mnot(M m) { return _mm_xor_ps(m, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    static I maskBits(M m) { return _mm_castps_si128(m); }
+    static I maskToInt(M m) { return _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(1)); }
+};
+#endif
+
+static const int32_t primeX = 501125321;
+static const int32_t primeY = 1136930381;
+static const int32_t primeZ = 1720413743;
+static const int32_t primeW = 1066037191;
+
+template<typename L>
+static typename L::I hashCorner(typename L::I h)
+{
+    h = L::muli(h, L::seti(0x27D4EB2D));
+    return L::xori(h, L::srli(h, 15));
+}
+
+template<typename L>
+static typename L::F flipSign(typename L::I h, int32_t bit, typename L::F v)
+{
+    return L::select(L::eqi(L::andi(h, L::seti(bit)), L::seti(0)), v, L::neg(v));
+}
+
+//Gradient selection after Gustavson's simplexnoise1234
+template<typename L>
+static typename L::F grad2(typename L::I h, typename L::F x, typename L::F y)
+{
+    typename L::M low = L::eqi(L::andi(h, L::seti(4)), L::seti(0));
+    typename L::F u = L::select(low, x, y);
+    typename L::F v = L::select(low, y, x);
+    return L::add(flipSign<L>(h, 1, u), flipSign<L>(h, 2, L::add(v, v)));
+}
+
+template<typename L>
+static typename L::F grad3(typename L::I h, typename L::F x, typename L::F y, typename L::F z)
+{
+    typename L::F u = L::select(L::eqi(L::andi(h, L::seti(8)), L::seti(0)), x, y);
+    typename L::F v = L::select(L::eqi(L::andi(h, L::seti(12)), L::seti(0)), y,
+        L::select(L::eqi(L::andi(h, L::seti(13)), L::seti(12)), x, z));
+    return L::add(flipSign<L>(h, 1, u), flipSign<L>(h, 2, v));
+}
+
+template<typename L>
+static typename L::F grad4(typename L::I h, typename L::F x, typename L::F y, typename L::F z, typename L::F w)
+{
+    typename L::I top = L::andi(h, L::seti(24));
+    typename L::F u = L::select(L::eqi(top, L::seti(24)), y, x);
+    typename L::F v = L::select(L::eqi(L::andi(h, L::seti(16)), L::seti(0)), y, z);
+    typename L::F s = L::select(L::eqi(top, L::seti(0)), z, w);
+    return L::add(L::add(flipSign<L>(h, 1, u), flipSign<L>(h, 2, v)), flipSign<L>(h, 4, s));
+}
+
+//max(t, 0)^4 * gradient
+template<typename L>
+static typename L::F falloff(typename L::F t, typename L::F gradient)
+{
+    t = L::max(t, L::set(0.0f));
+    t = L::mul(t, t);
+    return L::mul(L::mul(t, t), gradient);
+}
+
+template<typename L>
+static typename L::I offset(typename L::I base, typename L::M step, int32_t prime)
+{
+    return L::addi(base, L::andi(L::maskBits(step), L::seti(prime)));
+}
+
+template<typename L>
+static typename L::F simplex2(typename L::I seed, typename L::F x, typename L::F y)
+{
+    typedef typename L::F F;
+    typedef typename L::I I;
+    const float f2 = 0.36602540378f;
+    const float g2 = 0.21132486540f;
+
+    F s = L::mul(L::add(x, y), L::set(f2));
+    F i = L::floor(L::add(x, s));
+    F j = L::floor(L::add(y, s));
+    F t = L::mul(L::add(i, j), L::set(g2));
+    F x0 = L::sub(x, L::sub(i, t));
+    F y0 = L::sub(y, L::sub(j, t));
+
+    typename L::M lower = L::gt(x0, y0);
+    F i1 = L::maskToFloat(lower);
+    F j1 = L::sub(L::set(1.0f), i1);
+    F x1 = L::add(L::sub(x0, i1), L::set(g2));
+    F y1 = L::add(L::sub(y0, j1), L::set(g2));
+    F x2 = L::add(x0, L::set(2.0f * g2 - 1.0f));
+    F y2 = L::add(y0, L::set(2.0f * g2 - 1.0f));
+
+    I xp = L::muli(L::toInt(i), L::seti(primeX));
+    I yp = L::muli(L::toInt(j), L::seti(primeY));
+    I h0 = hashCorner<L>(L::xori(seed, L::xori(xp, yp)));
+    I h1 = hashCorner<L>(L::xori(seed, L::xori(offset<L>(xp, lower, primeX), offset<L>(yp, L::mnot(lower), primeY))));
+    I h2 = hashCorner<L>(L::xori(seed, L::xori(L::addi(xp, L::seti(primeX)), L::addi(yp, L::seti(primeY)))));
+
+    F half = L::set(0.5f);
+    F n0 = falloff<L>(L::sub(L::sub(half, L::mul(x0, x0)), L::mul(y0, y0)), grad2<L>(h0, x0, y0));
+    F n1 = falloff<L>(L::sub(L::sub(half, L::mul(x1, x1)), L::mul(y1, y1)), grad2<L>(h1, x1, y1));
+    F n2 = falloff<L>(L::sub(L::sub(half, L::mul(x2, x2)), L::mul(y2, y2)), grad2<L>(h2, x2, y2));
+    return L::mul(L::set(40.0f), L::add(L::add(n0, n1), n2));
+}
+
+template<typename L>
+static typename L::F simplex3(typename L::I seed, typename L::F x, typename L::F y, typename L::F z)
+{
+    typedef typename L::F F;
+    typedef typename L::I I;
+    typedef typename L::M M;
+    const float f3 = 1.0f / 3.0f;
+    const float g3 = 1.0f / 6.0f;
+
+    F s = L::mul(L::add(L::add(x, y), z), L::set(f3));
+    F i = L::floor(L::add(x, s));
+    F j = L::floor(L::add(y, s));
+    F k = L::floor(L::add(z, s));
+    F t = L::mul(L::add(L::add(i, j), k), L::set(g3));
+    F x0 = L::sub(x, L::sub(i, t));
+    F y0 = L::sub(y, L::sub(j, t));
+    F z0 = L::sub(z, L::sub(k, t));
+
+    //Which of the six simplices, a: x >= y, b: y >= z, c: x >= z
+    M a = L::mnot(L::gt(y0, x0));
+    M b = L::mnot(L::gt(z0, y0));
+    M c = L::mnot(L::gt(z0, x0));
+    M i1 = L::mand(a, c);
+    M j1 = L::mand(L::mnot(a), b);
+    M k1 = L::mand(L::mnot(c), L::mnot(b));
+    M i2 = L::mor(a, c);
+    M j2 = L::mor(L::mnot(a), b);
+    M k2 = L::mnot(L::mand(b, c));
+
+    F x1 = L::add(L::sub(x0, L::maskToFloat(i1)), L::set(g3));
+    F y1 = L::add(L::sub(y0, L::maskToFloat(j1)), L::set(g3));
+    F z1 = L::add(L::sub(z0, L::maskToFloat(k1)), L::set(g3));
+    F x2 = L::add(L::sub(x0, L::maskToFloat(i2)), L::set(2.0f * g3));
+    F y2 = L::add(L::sub(y0, L::maskToFloat(j2)), L::set(2.0f * g3));
+    F z2 = L::add(L::sub(z0, L::maskToFloat(k2)), L::set(2.0f * g3));
+    F x3 = L::add(x0, L::set(3.0f * g3 - 1.0f));
+    F y3 = L::add(y0, L::set(3.0f * g3 - 1.0f));
+    F z3 = L::add(z0, L::set(3.0f * g3 - 1.0f));
+
+    I xp = L::muli(L::toInt(i), L::seti(primeX));
+    I yp = L::muli(L::toInt(j), L::seti(primeY));
+    I zp = L::muli(L::toInt(k), L::seti(primeZ));
+    I h0 = hashCorner<L>(L::xori(seed, L::xori(L::xori(xp, yp), zp)));
+    I h1 = hashCorner<L>(L::xori(seed, L::xori(L::xori(offset<L>(xp, i1, primeX), offset<L>(yp, j1, primeY)), offset<L>(zp, k1, primeZ))));
+    I h2 = hashCorner<L>(L::xori(seed, L::xori(L::xori(offset<L>(xp, i2, primeX), offset<L>(yp, j2, primeY)), offset<L>(zp, k2, primeZ))));
+    I h3 = hashCorner<L>(L::xori(seed, L::xori(L::xori(L::addi(xp, L::seti(primeX)), L::addi(yp, L::seti(primeY))), L::addi(zp, L::seti(primeZ)))));
+
+    F r = L::set(0.6f);
+    F n0 = falloff<L>(L::sub(L::sub(L::sub(r, L::mul(x0, x0)), L::mul(y0, y0)), L::mul(z0, z0)), grad3<L>(h0, x0, y0, z0));
+    F n1 = falloff<L>(L::sub(L::sub(L::sub(r, L::mul(x1, x1)), L::mul(y1, y1)), L::mul(z1, z1)), grad3<L>(h1, x1, y1, z1));
+    F n2 = falloff<L>(L::sub(L::sub(L::sub(r, L::mul(x2, x2)), L::mul(y2, y2)), L::mul(z2, z2)), grad3<L>(h2, x2, y2, z2));
+    F n3 = falloff<L>(L::sub(L::sub(L::sub(r, L::mul(x3, x3)), L::mul(y3, y3)), L::mul(z3, z3)), grad3<L>(h3, x3, y3, z3));
+    return L::mul(L::set(32.0f), L::add(L::add(n0, n1), L::add(n2, n3)));
+}
+
+template<typename L>
+static typename L::F simplex4(typename L::I seed, typename L::F x, typename L::F y, typename L::F z, typename L::F w)
+{
+    typedef typename L::F F;
+    typedef typename L::I I;
+    typedef typename L::M M;
+    const float f4 = 0.30901699437f;
+    const float g4 = 0.13819660113f;
+
+    F s = L::mul(L::add(L::add(x, y), L::add(z, w)), L::set(f4));
+    F i = L::floor(L::add(x, s));
+    F j = L::floor(L::add(y, s));
+    F k = L::floor(L::add(z, s));
+    F l = L::floor(L::add(w, s));
+    F t = L::mul(L::add(L::add(i, j), L::add(k, l)), L::set(g4));
+    F x0 = L::sub(x, L::sub(i, t));
+    F y0 = L::sub(y, L::sub(j, t));
+    F z0 = L::sub(z, L::sub(k, t));
+    F w0 = L::sub(w, L::sub(l, t));
+
+    //Rank of each coordinate decides the traversal order through the simplex
+    M xy = L::gt(x0, y0), xz = L::gt(x0, z0), xw = L::gt(x0, w0);
+    M yz = L::gt(y0, z0), yw = L::gt(y0, w0), zw = L::gt(z0, w0);
+    I rankX = L::addi(L::addi(L::maskToInt(xy), L::maskToInt(xz)), L::maskToInt(xw));
+    I rankY = L::addi(L::addi(L::maskToInt(L::mnot(xy)), L::maskToInt(yz)), L::maskToInt(yw));
+    I rankZ = L::addi(L::addi(L::maskToInt(L::mnot(xz)), L::maskToInt(L::mnot(yz))), L::maskToInt(zw));
+    I rankW = L::addi(L::addi(L::maskToInt(L::mnot(xw)), L::maskToInt(L::mnot(yw))), L::maskToInt(L::mnot(zw)));
+
+    I xp = L::muli(L::toInt(i), L::seti(primeX));
+    I yp = L::muli(L::toInt(j), L::seti(primeY));
+    I zp = L::muli(L::toInt(k), L::seti(primeZ));
+    I wp = L::muli(L::toInt(l), L::seti(primeW));
+
+    F result = L::set(0.0f);
+    for (int corner = 0; corner < 5; corner++)
+    {
+        F cx = x0, cy = y0, cz = z0, cw = w0;
+        I hx = xp, hy = yp, hz = zp, hw = wp;
+        if (corner > 0)
+        {
+            //Corner n steps along the coordinates ranked above 3 - n
+            I threshold = L::seti(3 - corner);
+            M sx = L::gti(rankX, threshold), sy = L::gti(rankY, threshold);
+            M sz = L::gti(rankZ, threshold), sw = L::gti(rankW, threshold);
+            F g = L::set(corner * g4);
+            cx = L::add(L::sub(x0, L::maskToFloat(sx)), g);
+            cy = L::add(L::sub(y0, L::maskToFloat(sy)), g);
+            cz = L::add(L::sub(z0, L::maskToFloat(sz)), g);
+            cw = L::add(L::sub(w0, L::maskToFloat(sw)), g);
+            hx = offset<L>(xp, sx, primeX);
+            hy = offset<L>(yp, sy, primeY);
+            hz = offset<L>(zp, sz, primeZ);
+            hw = offset<L>(wp, sw, primeW);
+        }
+
+        I h = hashCorner<L>(L::xori(seed, L::xori(L::xori(hx, hy), L::xori(hz, hw))));
+        F d = L::sub(L::sub(L::sub(L::sub(L::set(0.6f), L::mul(cx, cx)), L::mul(cy, cy)), L::mul(cz, cz)), L::mul(cw, cw));
+        result = L::add(result, falloff<L>(d, grad4<L>(h, cx, cy, cz, cw)));
+    }
+    return L::mul(L::set(27.0f), result);
+}
+
+template<typename L>
+static typename L::F fade(typename L::F t)
+{
+    //t^3 (t (6t - 15) + 10)
+    typename L::F p = L::add(L::mul(t, L::sub(L::mul(t, L::set(6.0f)), L::set(15.0f))), L::set(10.0f));
+    return L::mul(L::mul(L::mul(t, t), t), p);
+}
+
+template<typename L>
+static typename L::F lerp(typename L::F t, typename L::F a, typename L::F b)
+{
+    return L::add(a, L::mul(t, L::sub(b, a)));
+}
+
+//Improved Perlin noise, corners are enumerated with bit d of the corner index
+//selecting the upper lattice point along dimension d
+template<typename L, int Dim>
+static typename L::F gradient(typename L::I seed, const typename L::F* p)
+{
+    typedef typename L::F F;
+    typedef typename L::I I;
+    static const int32_t primes[4] = { primeX, primeY, primeZ, primeW };
+
+    F lo[Dim], hi[Dim], u[Dim];
+    I hashLo[Dim], hashHi[Dim];
+    for (int d = 0; d < Dim; d++)
+    {
+        F cell = L::floor(p[d]);
+        lo[d] = L::sub(p[d], cell);
+        hi[d] = L::sub(lo[d], L::set(1.0f));
+        u[d] = fade<L>(lo[d]);
+        hashLo[d] = L::muli(L::toInt(cell), L::seti(primes[d]));
+        hashHi[d] = L::addi(hashLo[d], L::seti(primes[d]));
+    }
+
+    F n[1 << Dim];
+    for (int corner = 0; corner < (1 << Dim); corner++)
+    {
+        I h = seed;
+        F c[Dim];
+        for (int d = 0; d < Dim; d++)
+        {
+            bool upper = (corner >> d) & 1;
+            h = L::xori(h, upper ? hashHi[d] : hashLo[d]);
+            c[d] = upper ? hi[d] : lo[d];
+        }
+        h = hashCorner<L>(h);
+        if (Dim == 2)
+            n[corner] = grad2<L>(h, c[0], c[1]);
+        else if (Dim == 3)
+            n[corner] = grad3<L>(h, c[0], c[1], c[Dim > 2 ? 2 : 0]);
+        else
+            n[corner] = grad4<L>(h, c[0], c[1], c[Dim > 2 ? 2 : 0], c[Dim > 3 ? 3 : 0]);
+    }
+
+    //Collapse one dimension per pass
+    for (int d = 0; d < Dim; d++)
+    {
+        int half = 1 << (Dim - d - 1);
+        for (int corner = 0; corner < half; corner++)
+            n[corner] = lerp<L>(u[d], n[corner * 2], n[corner * 2 + 1]);
+    }
+
+    static const float scale[5] = { 0.0f, 0.0f, 0.507f, 0.936f, 0.87f };
+    return L::mul(L::set(scale[Dim]), n[0]);
+}
+
+template<typename L, int Dim>
+static typename L::F base(NoiseType type, typename L::I seed, const typename L::F* p)
+{
+    if (type == NoiseType::Gradient)
+        return gradient<L, Dim>(seed, p);
+    if (Dim == 2)
+        return simplex2<L>(seed, p[0], p[1]);
+    if (Dim == 3)
+        return simplex3<L>(seed, p[0], p[1], p[Dim > 2 ? 2 : 0]);
+    return simplex4<L>(seed, p[0], p[1], p[Dim > 2 ? 2 : 0], p[Dim > 3 ? 3 : 0]);
+}
+
+template<typename L, int Dim>
+static typename L::F evaluate(const NoiseSettings& settings, const typename L::F* p)
+{
+    typedef typename L::F F;
+
+    F scaled[Dim];
+    float frequency = settings.frequency;
+    if (settings.fractal == NoiseFractal::None)
+    {
+        for (int d = 0; d < Dim; d++)
+            scaled[d] = L::mul(p[d], L::set(frequency));
+        return base<L, Dim>(settings.type, L::seti((int32_t)settings.seed), scaled);
+    }
+
+    F sum = L::set(0.0f);
+    float amplitude = 1.0f;
+    float amplitudeSum = 0.0f;
+    uint32_t octaves = settings.octaves ? settings.octaves : 1;
+    for (uint32_t octave = 0; octave < octaves; octave++)
+    {
+        for (int d = 0; d < Dim; d++)
+            scaled[d] = L::mul(p[d], L::set(frequency));
+
+        //Each octave gets its own seed so lattice features do not line up
+        F n = base<L, Dim>(settings.type, L::seti((int32_t)(settings.seed + octave)), scaled);
+        if (settings.fractal == NoiseFractal::Ridged)
+        {
+            n = L::sub(L::set(1.0f), L::abs(n));
+            n = L::mul(n, n);
+        }
+
+        sum = L::add(sum, L::mul(n, L::set(amplitude)));
+        amplitudeSum += amplitude;
+        amplitude *= settings.gain;
+        frequency *= settings.lacunarity;
+    }
+
+    sum = L::mul(sum, L::set(amplitudeSum > 0.0f ? 1.0f / amplitudeSum : 0.0f));
+    if (settings.fractal == NoiseFractal::Ridged)
+        sum = L::sub(L::add(sum, sum), L::set(1.0f));
+    return sum;
+}
+
+template<int Dim>
+static void evaluateBatch(const NoiseSettings& settings, const float* const* coords, float* out, size_t count)
+{
+    ESGS_COUNT(NoiseSample, count);
+
+    size_t i = 0;
+#ifdef ESGS_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 p[Dim];
+        for (int d = 0; d < Dim; d++)
+            p[d] = _mm_loadu_ps(coords[d] + i);
+        _mm_storeu_ps(out + i, evaluate<SseLane, Dim>(settings, p));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        float p[Dim];
+        for (int d = 0; d < Dim; d++)
+            p[d] = coords[d][i];
+        out[i] = evaluate<ScalarLane, Dim>(settings, p);
+    }
+}
+
+Noise::Noise(const NoiseSettings& settings) : m_settings(settings)
+{
+}
+
+void Noise::setSettings(const NoiseSettings& settings)
+{
+    m_settings = settings;
+}
+
+const NoiseSettings& Noise::getSettings() const
+{
+    return m_settings;
+}
+
+float Noise::sample(float x, float y) const
+{
+    float p[2] = { x, y };
+    return evaluate<ScalarLane, 2>(m_settings, p);
+}
+
+float Noise::sample(float x, float y, float z) const
+{
+    float p[3] = { x, y, z };
+    return evaluate<ScalarLane, 3>(m_settings, p);
+}
+
+float Noise::sample(float x, float y, float z, float w) const
+{
+    float p[4] = { x, y, z, w };
+    return evaluate<ScalarLane, 4>(m_settings, p);
+}
+
+void Noise::sample(const float* x, const float* y, float* out, size_t count) const
+{
+    const float* coords[2] = { x, y };
+    evaluateBatch<2>(m_settings, coords, out, count);
+}
+
+void Noise::sample(const float* x, const float* y, const float* z, float* out, size_t count) const
+{
+    const float* coords[3] = { x, y, z };
+    evaluateBatch<3>(m_settings, coords, out, count);
+}
+
+void Noise::sample(const float* x, const float* y, const float* z, const float* w, float* out, size_t count) const
+{
+    const float* coords[4] = { x, y, z, w };
+    evaluateBatch<4>(m_settings, coords, out, count);
+}
+
+//Rows are evaluated in chunks that fit on the stack
+#define NOISE_ROW_CHUNK 256
+
+void Noise::fillGrid(float originX, float originY, float step, uint32_t width, uint32_t height, float* out, bool parallel) const
+{
+    const NoiseSettings settings = m_settings;
+    auto rows = [=](size_t begin, size_t end)
+    {
+        float xs[NOISE_ROW_CHUNK], ys[NOISE_ROW_CHUNK];
+        const float* coords[2] = { xs, ys };
+        for (size_t j = begin; j < end; j++)
+        {
+            for (uint32_t i0 = 0; i0 < width; i0 += NOISE_ROW_CHUNK)
+            {
+                uint32_t n = width - i0 < NOISE_ROW_CHUNK ? width - i0 : NOISE_ROW_CHUNK;
+                for (uint32_t k = 0; k < n; k++)
+                {
+                    xs[k] = originX + (float)(i0 + k) * step;
+                    ys[k] = originY + (float)j * step;
+                }
+                evaluateBatch<2>(settings, coords, out + j * width + i0, n);
+            }
+        }
+    };
+
+    if (parallel)
+        __parallel_for(height, width ? (4096 + width - 1) / width : 1, rows);
+    else
+        rows(0, height);
+}
+
+void Noise::fillGrid(float originX, float originY, float originZ, float step, uint32_t width, uint32_t height,
+    uint32_t depth, float* out, bool parallel) const
+{
+    const NoiseSettings settings = m_settings;
+    auto rows = [=](size_t begin, size_t end)
+    {
+        float xs[NOISE_ROW_CHUNK], ys[NOISE_ROW_CHUNK], zs[NOISE_ROW_CHUNK];
+        const float* coords[3] = { xs, ys, zs };
+        for (size_t row = begin; row < end; row++)
+        {
+            size_t j = row % height;
+            size_t k = row / height;
+            for (uint32_t i0 = 0; i0 < width; i0 += NOISE_ROW_CHUNK)
+            {
+                uint32_t n = width - i0 < NOISE_ROW_CHUNK ? width - i0 : NOISE_ROW_CHUNK;
+                for (uint32_t c = 0; c < n; c++)
+                {
+                    xs[c] = originX + (float)(i0 + c) * step;
+                    ys[c] = originY + (float)j * step;
+                    zs[c] = originZ + (float)k * step;
+                }
+                evaluateBatch<3>(settings, coords, out + row * width + i0, n);
+            }
+        }
+    };
+
+    size_t count = (size_t)height * depth;
+    if (parallel)
+        __parallel_for(count, width ? (4096 + width - 1) / width : 1, rows);
+    else
+        rows(0, count);
+}
+
+ESGS_STRICT_FLOAT_END
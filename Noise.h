@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Export.h"
+
+enum class NoiseType : uint8_t
+{
+	Simplex,
+	//Improved Perlin noise on the integer lattice
+	Gradient
+};
+
+enum class NoiseFractal : uint8_t
+{
+	None,
+	FBm,
+	//1 - |noise| squared per octave, sharp crests for mountain ranges
+	Ridged
+};
+
+struct NoiseSettings
+{
+	NoiseType type = NoiseType::Simplex;
+	NoiseFractal fractal = NoiseFractal::None;
+	uint32_t octaves = 4;
+	float frequency = 1.0f;
+	float lacunarity = 2.0f;
+	float gain = 0.5f;
+	uint32_t seed = 0;
+};
+
+//Seedable 2D/3D/4D simplex and gradient noise, roughly in [-1, 1]. Lattice corners
+//are hashed instead of looked up in a permutation table, so the domain does not
+//repeat and the SSE2 batch path computes the same bits as the scalar path; results
+//depend only on the settings, also with FMA targets since Noise.cpp is compiled without
+//contraction. Inputs must stay within the int32 range.
+class ESGS_EXPORT Noise
+{
+public:
+	Noise(const NoiseSettings& settings = NoiseSettings());
+
+	void setSettings(const NoiseSettings& settings);
+	const NoiseSettings& getSettings() const;
+
+	float sample(float x, float y) const;
+	float sample(float x, float y, float z) const;
+	float sample(float x, float y, float z, float w) const;
+	float sample(const Vector2D& p) const { return sample(p.x, p.y); }
+	float sample(const Vector3D& p) const { return sample(p.x, p.y, p.z); }
+	float sample(const Vector4D& p) const { return sample(p.x, p.y, p.z, p.w); }
+
+	//Structure of arrays batches, four points per SSE iteration
+	void sample(const float* x, const float* y, float* out, size_t count) const;
+	void sample(const float* x, const float* y, const float* z, float* out, size_t count) const;
+	void sample(const float* x, const float* y, const float* z, const float* w, float* out, size_t count) const;
+
+	//out[j * width + i] = sample(originX + i * step, originY + j * step), rows are
+	//split across threads when parallel is set
+	void fillGrid(float originX, float originY, float step, uint32_t width, uint32_t height,
+		float* out, bool parallel = true) const;
+	//out[(k * height + j) * width + i], slabs of rows are split across threads
+	void fillGrid(float originX, float originY, float originZ, float step, uint32_t width, uint32_t height,
+		uint32_t depth, float* out, bool parallel = true) const;
+
+private:
+	NoiseSettings m_settings;
+};
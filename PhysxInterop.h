@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <PxPhysics.h>
+#include <PxPhysicsAPI.h>
+#include "Vector2D.h"
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include "Quaternion.h"
+#include "Matrix4x4.h"
+#include "TransformBatch.h"
+#include "Simd.h"
+#include "Export.h"
+
+static_assert(std::is_standard_layout<Vector2D>::value && sizeof(Vector2D) == sizeof(physx::PxVec2), "Vector2D layout must match PxVec2");
+static_assert(std::is_standard_layout<Vector3D>::value && sizeof(Vector3D) == sizeof(physx::PxVec3), "Vector3D layout must match PxVec3");
+static_assert(std::is_standard_layout<Vector4D>::value && sizeof(Vector4D) == sizeof(physx::PxVec4), "Vector4D layout must match PxVec4");
+static_assert(std::is_standard_layout<Quaternion>::value && sizeof(Quaternion) == sizeof(physx::PxQuat), "Quaternion layout must match PxQuat");
+static_assert(sizeof(Matrix4x4) == sizeof(physx::PxMat44), "Matrix4x4 layout must match PxMat44");
+
+static_assert(offsetof(Vector3D, x) == offsetof(physx::PxVec3, x) && offsetof(Vector3D, y) == offsetof(physx::PxVec3, y) &&
+	offsetof(Vector3D, z) == offsetof(physx::PxVec3, z), "Vector3D member order must match PxVec3");
+static_assert(offsetof(Vector4D, x) == offsetof(physx::PxVec4, x) && offsetof(Vector4D, w) == offsetof(physx::PxVec4, w),
+	"Vector4D member order must match PxVec4");
+static_assert(offsetof(Quaternion, x) == offsetof(physx::PxQuat, x) && offsetof(Quaternion, y) == offsetof(physx::PxQuat, y) &&
+	offsetof(Quaternion, z) == offsetof(physx::PxQuat, z) && offsetof(Quaternion, w) == offsetof(physx::PxQuat, w),
+	"Quaternion member order must match PxQuat");
+
+//PhysX adapter for the math kit, the core headers do not include PhysX.
+//Zero-copy views and bulk conversion between PhysX arrays and the kit's types.
+//Matrix4x4 rows (row-vector convention) are stored exactly like PxMat44 columns
+//(column-vector convention), so both describe the same transform with the same bytes;
+//this is what Matrix4x4(const PxMat44&) and toPxMat44() rely on.
+class ESGS_EXPORT PhysxInterop
+{
+public:
+	static physx::PxVec2 toPxVec2(const Vector2D& v) { return physx::PxVec2(v.x, v.y); }
+	static physx::PxVec3 toPxVec3(const Vector3D& v) { return physx::PxVec3(v.x, v.y, v.z); }
+	static physx::PxVec4 toPxVec4(const Vector4D& v) { return physx::PxVec4(v.x, v.y, v.z, v.w); }
+	static physx::PxQuat toPxQuat(const Quaternion& q) { return physx::PxQuat(q.x, q.y, q.z, q.w); }
+	static Quaternion toQuaternion(const physx::PxQuat& q) { return Quaternion(q.x, q.y, q.z, q.w); }
+
+	//Replaces Matrix4x4::getPhysxMat44()
+	static physx::PxMat44 toPxMat44(const Matrix4x4& matrix)
+	{
+		physx::PxMat44 mat;
+		::memcpy((void*)&mat, matrix.m_mat, sizeof(float) * 16);
+		return mat;
+	}
+
+	static Vector3D* view(physx::PxVec3* data) { return reinterpret_cast<Vector3D*>(data); }
+	static const Vector3D* view(const physx::PxVec3* data) { return reinterpret_cast<const Vector3D*>(data); }
+	static Vector2D* view(physx::PxVec2* data) { return reinterpret_cast<Vector2D*>(data); }
+	static const Vector2D* view(const physx::PxVec2* data) { return reinterpret_cast<const Vector2D*>(data); }
+	static Vector4D* view(physx::PxVec4* data) { return reinterpret_cast<Vector4D*>(data); }
+	static const Vector4D* view(const physx::PxVec4* data) { return reinterpret_cast<const Vector4D*>(data); }
+	static Quaternion* view(physx::PxQuat* data) { return reinterpret_cast<Quaternion*>(data); }
+	static const Quaternion* view(const physx::PxQuat* data) { return reinterpret_cast<const Quaternion*>(data); }
+	static Matrix4x4* view(physx::PxMat44* data) { return reinterpret_cast<Matrix4x4*>(data); }
+	static const Matrix4x4* view(const physx::PxMat44* data) { return reinterpret_cast<const Matrix4x4*>(data); }
+
+	static physx::PxVec3* view(Vector3D* data) { return reinterpret_cast<physx::PxVec3*>(data); }
+	static const physx::PxVec3* view(const Vector3D* data) { return reinterpret_cast<const physx::PxVec3*>(data); }
+	static physx::PxVec2* view(Vector2D* data) { return reinterpret_cast<physx::PxVec2*>(data); }
+	static const physx::PxVec2* view(const Vector2D* data) { return reinterpret_cast<const physx::PxVec2*>(data); }
+	static physx::PxVec4* view(Vector4D* data) { return reinterpret_cast<physx::PxVec4*>(data); }
+	static const physx::PxVec4* view(const Vector4D* data) { return reinterpret_cast<const physx::PxVec4*>(data); }
+	static physx::PxQuat* view(Quaternion* data) { return reinterpret_cast<physx::PxQuat*>(data); }
+	static const physx::PxQuat* view(const Quaternion* data) { return reinterpret_cast<const physx::PxQuat*>(data); }
+	static physx::PxMat44* view(Matrix4x4* data) { return reinterpret_cast<physx::PxMat44*>(data); }
+	static const physx::PxMat44* view(const Matrix4x4* data) { return reinterpret_cast<const physx::PxMat44*>(data); }
+
+	static void copy(const physx::PxVec3* src, size_t count, Vector3D* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector3D)); }
+	static void copy(const Vector3D* src, size_t count, physx::PxVec3* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector3D)); }
+	static void copy(const physx::PxVec2* src, size_t count, Vector2D* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector2D)); }
+	static void copy(const Vector2D* src, size_t count, physx::PxVec2* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector2D)); }
+	static void copy(const physx::PxVec4* src, size_t count, Vector4D* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector4D)); }
+	static void copy(const Vector4D* src, size_t count, physx::PxVec4* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Vector4D)); }
+	static void copy(const physx::PxQuat* src, size_t count, Quaternion* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Quaternion)); }
+	static void copy(const Quaternion* src, size_t count, physx::PxQuat* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Quaternion)); }
+	static void copy(const physx::PxMat44* src, size_t count, Matrix4x4* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Matrix4x4)); }
+	static void copy(const Matrix4x4* src, size_t count, physx::PxMat44* dst) { ::memcpy((void*)dst, (const void*)src, count * sizeof(Matrix4x4)); }
+
+	//Character controller positions are double precision
+	static void copy(const physx::PxExtendedVec3* src, size_t count, Vector3D* dst)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[i].x = (float)src[i].x;
+			dst[i].y = (float)src[i].y;
+			dst[i].z = (float)src[i].z;
+		}
+	}
+
+	//For matrices whose rows must become PxMat44 rows rather than columns,
+	//e.g. data authored for column-vector shaders
+	static void copyTransposed(const physx::PxMat44* src, size_t count, Matrix4x4* dst)
+	{
+		transpose(reinterpret_cast<const float*>(src), count, reinterpret_cast<float*>(dst));
+	}
+
+	static void copyTransposed(const Matrix4x4* src, size_t count, physx::PxMat44* dst)
+	{
+		transpose(reinterpret_cast<const float*>(src), count, reinterpret_cast<float*>(dst));
+	}
+
+	//Rigid actor poses to world matrices with unit scale
+	static void copy(const physx::PxTransform* src, size_t count, Matrix4x4* dst)
+	{
+		Vector3D unit(1.0f, 1.0f, 1.0f);
+		for (size_t i = 0; i < count; i++)
+			TransformBatch::compose(*view(&src[i].p), *view(&src[i].q), unit, dst[i]);
+	}
+
+	//World matrices to rigid actor poses, any scale is dropped
+	static void copy(const Matrix4x4* src, size_t count, physx::PxTransform* dst)
+	{
+		Vector3D translation, scale;
+		Quaternion rotation;
+		for (size_t i = 0; i < count; i++)
+		{
+			TransformBatch::decompose(src[i], translation, rotation, scale);
+			dst[i].p = physx::PxVec3(translation.x, translation.y, translation.z);
+			dst[i].q = physx::PxQuat(rotation.x, rotation.y, rotation.z, rotation.w);
+		}
+	}
+
+private:
+	static void transpose(const float* src, size_t count, float* dst)
+	{
+		for (size_t i = 0; i < count; i++, src += 16, dst += 16)
+		{
+#ifdef ESGS_SSE2
+			__m128 r0 = _mm_loadu_ps(src);
+			__m128 r1 = _mm_loadu_ps(src + 4);
+			__m128 r2 = _mm_loadu_ps(src + 8);
+			__m128 r3 = _mm_loadu_ps(src + 12);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(dst, r0);
+			_mm_storeu_ps(dst + 4, r1);
+			_mm_storeu_ps(dst + 8, r2);
+			_mm_storeu_ps(dst + 12, r3);
+#else
+			float tmp[16];
+			::memcpy(tmp, src, sizeof(tmp));
+			for (int r = 0; r < 4; r++)
+			{
+				for (int c = 0; c < 4; c++)
+					dst[c * 4 + r] = tmp[r * 4 + c];
+			}
+#endif
+		}
+	}
+};
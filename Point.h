@@ -1,4 +1,5 @@
 #pragma once
+#include "LayoutTraits.h"
 
 struct Point
 {
@@ -10,14 +11,8 @@ struct Point
 	{
 	}
 
-	Point(const Point& point) : x(point.x), y(point.y)
-	{
-	}
-
-	~Point()
-	{
-	}
-
 	int x = 0;
 	int y = 0;
-};
\ No newline at end of file
+};
+
+ESGS_CHECK_LAYOUT(Point, sizeof(int) * 2);
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include "Export.h"
+
+//Hot path side of Instrumentation.h, light enough for the core math headers.
+//Compiled in only with ESGS_INSTRUMENTATION defined, without it ESGS_COUNT and
+//ESGS_SCOPED_TIMER expand to nothing. Reporting lives in Instrumentation.h.
+enum class ProfileCounter : int
+{
+	MatrixMultiply,
+	MatrixInverse,
+	QuaternionSlerp,
+	VectorNormalize,
+	KernelGeneration,
+	BatchVector,
+	BatchMatrix,
+	BatchQuaternion,
+	BatchTransform,
+	BatchCulling,
+	BatchEncoding,
+	NoiseSample,
+	Count
+};
+
+#ifdef ESGS_INSTRUMENTATION
+//Out of line so per-thread counter storage and clocks stay out of including headers
+namespace profile_counters
+{
+	ESGS_EXPORT void count(ProfileCounter counter, uint64_t elements);
+	ESGS_EXPORT void addTime(ProfileCounter counter, uint64_t nanoseconds);
+	//Monotonic clock in nanoseconds
+	ESGS_EXPORT uint64_t now();
+}
+
+class ScopedProfileTimer
+{
+public:
+	ScopedProfileTimer(ProfileCounter counter) : m_counter(counter), m_start(profile_counters::now())
+	{
+	}
+
+	~ScopedProfileTimer()
+	{
+		profile_counters::addTime(m_counter, profile_counters::now() - m_start);
+	}
+
+private:
+	ProfileCounter m_counter;
+	uint64_t m_start;
+};
+
+#define ESGS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ESGS_PROFILE_CONCAT(a, b) ESGS_PROFILE_CONCAT_IMPL(a, b)
+#define ESGS_COUNT(counter, elements) profile_counters::count(ProfileCounter::counter, (uint64_t)(elements))
+#define ESGS_SCOPED_TIMER(counter) ScopedProfileTimer ESGS_PROFILE_CONCAT(esgs_profile_timer_, __LINE__)(ProfileCounter::counter)
+#else
+#define ESGS_COUNT(counter, elements) ((void)0)
+#define ESGS_SCOPED_TIMER(counter) ((void)0)
+#endif
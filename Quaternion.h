@@ -3,7 +3,7 @@
 #include <cmath>
 #include "Matrix4x4.h"
 #include "Math.h"
-#include "DLL.h"
+#include "Export.h"
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
@@ -166,6 +166,7 @@ public:
 
 	Quaternion slerp(Quaternion q, float t)
 	{
+		ESGS_COUNT(QuaternionSlerp, 1);
 		Quaternion ret;
 
 		float fCos = dot(q);
@@ -384,4 +385,6 @@ private:
 	}
 
 	friend class CsGame;
-};
\ No newline at end of file
+};
+
+ESGS_CHECK_LAYOUT(Quaternion, sizeof(float) * 4);
\ No newline at end of file
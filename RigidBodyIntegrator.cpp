@@ -0,0 +1,212 @@
+#include "RigidBodyIntegrator.h"
+#include "AsyncCore.h"
+#include "Simd.h"
+#include <cmath>
+
+//Bodies per task
+#define INTEGRATOR_PARALLEL_CHUNK 4096
+
+namespace
+{
+    struct ScalarLane
+    {
+        typedef float F;
+        enum { width = 1 };
+
+        static F set(float v) { return v; }
+        static F load(const float* p) { return *p; }
+        static void store(float* p, F v) { *p = v; }
+        static F add(F a, F b) { return a + b; }
+        static F sub(F a, F b) { return a - b; }
+        static F mul(F a, F b) { return a * b; }
+        static F div(F a, F b) { return a / b; }
+        static F sqrt(F a) { return sqrtf(a); }
+    };
+
+#ifdef ESGS_SSE2
+    struct SseLane
+    {
+        typedef __m128 F;
+        enum { width = 4 };
+
+        static F set(float v) { return _mm_set1_ps(v); }
+        static F load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+        static F add(F a, F b) { return _mm_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F div(F a, F b) { return _mm_div_ps(a, b); }
+        static F sqrt(F a) { return _mm_sqrt_ps(a); }
+    };
+#endif
+
+    struct StepConstants
+    {
+        float dt;
+        float gravity[3];
+        float linearDamping;
+        float angularDamping;
+    };
+}
+
+template<typename L>
+static typename L::F loadOptional(const float* p, size_t i)
+{
+    return p ? L::load(p + i) : L::set(0.0f);
+}
+
+template<typename L>
+static void rotateLanes(const RigidBodyStates& s, const StepConstants& c, size_t i)
+{
+    typedef typename L::F F;
+    F damping = L::set(c.angularDamping);
+    F wx = L::mul(L::load(s.wx + i), damping);
+    F wy = L::mul(L::load(s.wy + i), damping);
+    F wz = L::mul(L::load(s.wz + i), damping);
+    L::store(s.wx + i, wx);
+    L::store(s.wy + i, wy);
+    L::store(s.wz + i, wz);
+
+    F qx = L::load(s.qx + i);
+    F qy = L::load(s.qy + i);
+    F qz = L::load(s.qz + i);
+    F qw = L::load(s.qw + i);
+
+    //(w, 0) * q = (w qw + w x qv, -w . qv)
+    F h = L::set(0.5f * c.dt);
+    F dx = L::add(L::mul(wx, qw), L::sub(L::mul(wy, qz), L::mul(wz, qy)));
+    F dy = L::add(L::mul(wy, qw), L::sub(L::mul(wz, qx), L::mul(wx, qz)));
+    F dz = L::add(L::mul(wz, qw), L::sub(L::mul(wx, qy), L::mul(wy, qx)));
+    F dw = L::add(L::add(L::mul(wx, qx), L::mul(wy, qy)), L::mul(wz, qz));
+
+    qx = L::add(qx, L::mul(h, dx));
+    qy = L::add(qy, L::mul(h, dy));
+    qz = L::add(qz, L::mul(h, dz));
+    qw = L::sub(qw, L::mul(h, dw));
+
+    F lengthSq = L::add(L::add(L::mul(qx, qx), L::mul(qy, qy)), L::add(L::mul(qz, qz), L::mul(qw, qw)));
+    F inv = L::div(L::set(1.0f), L::sqrt(lengthSq));
+    L::store(s.qx + i, L::mul(qx, inv));
+    L::store(s.qy + i, L::mul(qy, inv));
+    L::store(s.qz + i, L::mul(qz, inv));
+    L::store(s.qw + i, L::mul(qw, inv));
+}
+
+template<typename L>
+static void eulerLanes(const RigidBodyStates& s, const StepConstants& c, size_t i)
+{
+    typedef typename L::F F;
+    F dt = L::set(c.dt);
+    F damping = L::set(c.linearDamping);
+    float* positions[3] = { s.px, s.py, s.pz };
+    float* velocities[3] = { s.vx, s.vy, s.vz };
+    const float* accelerations[3] = { s.ax, s.ay, s.az };
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        F a = L::add(L::set(c.gravity[axis]), loadOptional<L>(accelerations[axis], i));
+        F v = L::load(velocities[axis] + i);
+        v = L::mul(L::add(v, L::mul(a, dt)), damping);
+        L::store(velocities[axis] + i, v);
+        L::store(positions[axis] + i, L::add(L::load(positions[axis] + i), L::mul(v, dt)));
+    }
+}
+
+template<typename L>
+static void verletLanes(const RigidBodyStates& s, const StepConstants& c, size_t i)
+{
+    typedef typename L::F F;
+    F dtSq = L::set(c.dt * c.dt);
+    F invDt = L::set(1.0f / c.dt);
+    F damping = L::set(c.linearDamping);
+    float* positions[3] = { s.px, s.py, s.pz };
+    float* previous[3] = { s.prevX, s.prevY, s.prevZ };
+    float* velocities[3] = { s.vx, s.vy, s.vz };
+    const float* accelerations[3] = { s.ax, s.ay, s.az };
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        F a = L::add(L::set(c.gravity[axis]), loadOptional<L>(accelerations[axis], i));
+        F p = L::load(positions[axis] + i);
+        F prev = L::load(previous[axis] + i);
+        F next = L::add(L::add(p, L::mul(L::sub(p, prev), damping)), L::mul(a, dtSq));
+        L::store(previous[axis] + i, p);
+        L::store(positions[axis] + i, next);
+        if (velocities[axis])
+            L::store(velocities[axis] + i, L::mul(L::sub(next, p), invDt));
+    }
+}
+
+template<void (*Sse)(const RigidBodyStates&, const StepConstants&, size_t),
+    void (*Scalar)(const RigidBodyStates&, const StepConstants&, size_t)>
+static void runLanes(const RigidBodyStates& s, const StepConstants& c, bool parallel)
+{
+    auto body = [&](size_t begin, size_t end)
+    {
+        size_t i = begin;
+#ifdef ESGS_SSE2
+        for (; i + 4 <= end; i += 4)
+            Sse(s, c, i);
+#endif
+        for (; i < end; i++)
+            Scalar(s, c, i);
+    };
+
+    if (parallel)
+        __parallel_for(s.count, INTEGRATOR_PARALLEL_CHUNK, body);
+    else
+        body(0, s.count);
+}
+
+#ifdef ESGS_SSE2
+#define INTEGRATOR_LANES(kernel) runLanes<kernel<SseLane>, kernel<ScalarLane>>
+#else
+#define INTEGRATOR_LANES(kernel) runLanes<kernel<ScalarLane>, kernel<ScalarLane>>
+#endif
+
+static StepConstants makeConstants(const IntegratorSettings& settings, float dt)
+{
+    StepConstants c;
+    c.dt = dt;
+    c.gravity[0] = settings.gravity.x;
+    c.gravity[1] = settings.gravity.y;
+    c.gravity[2] = settings.gravity.z;
+    c.linearDamping = 1.0f / (1.0f + dt * settings.linearDamping);
+    c.angularDamping = 1.0f / (1.0f + dt * settings.angularDamping);
+    return c;
+}
+
+static bool hasOrientation(const RigidBodyStates& states)
+{
+    return states.qx && states.qy && states.qz && states.qw && states.wx && states.wy && states.wz;
+}
+
+void RigidBodyIntegrator::integrateEuler(const RigidBodyStates& states, const IntegratorSettings& settings, float dt, bool parallel)
+{
+    StepConstants c = makeConstants(settings, dt);
+    INTEGRATOR_LANES(eulerLanes)(states, c, parallel);
+    if (hasOrientation(states))
+        INTEGRATOR_LANES(rotateLanes)(states, c, parallel);
+}
+
+void RigidBodyIntegrator::integrateVerlet(const RigidBodyStates& states, const IntegratorSettings& settings, float dt, bool parallel)
+{
+    if (dt <= 0.0f)
+        return;
+
+    StepConstants c = makeConstants(settings, dt);
+    INTEGRATOR_LANES(verletLanes)(states, c, parallel);
+    if (hasOrientation(states))
+        INTEGRATOR_LANES(rotateLanes)(states, c, parallel);
+}
+
+void RigidBodyIntegrator::integrateRotations(const RigidBodyStates& states, float angularDamping, float dt, bool parallel)
+{
+    if (!hasOrientation(states))
+        return;
+
+    IntegratorSettings settings;
+    settings.angularDamping = angularDamping;
+    StepConstants c = makeConstants(settings, dt);
+    INTEGRATOR_LANES(rotateLanes)(states, c, parallel);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include "Vector3D.h"
+#include "Export.h"
+
+//Body state as structure of arrays, every array holds count entries. Optional arrays
+//may be null: acceleration (per body, added to gravity), the orientation group and the
+//Verlet previous positions when only integrateEuler() is used.
+struct RigidBodyStates
+{
+	float* px = nullptr;
+	float* py = nullptr;
+	float* pz = nullptr;
+
+	//Semi-implicit Euler state, written by integrateVerlet() when present
+	float* vx = nullptr;
+	float* vy = nullptr;
+	float* vz = nullptr;
+
+	//Position of the previous step for integrateVerlet()
+	float* prevX = nullptr;
+	float* prevY = nullptr;
+	float* prevZ = nullptr;
+
+	const float* ax = nullptr;
+	const float* ay = nullptr;
+	const float* az = nullptr;
+
+	//Orientation and world space angular velocity in radians per second
+	float* qx = nullptr;
+	float* qy = nullptr;
+	float* qz = nullptr;
+	float* qw = nullptr;
+	float* wx = nullptr;
+	float* wy = nullptr;
+	float* wz = nullptr;
+
+	size_t count = 0;
+};
+
+struct IntegratorSettings
+{
+	Vector3D gravity = Vector3D(0.0f, -9.81f, 0.0f);
+	//Per second, velocities are scaled by 1 / (1 + dt * damping) each step
+	float linearDamping = 0.0f;
+	float angularDamping = 0.0f;
+};
+
+//Batch integrators for bodies simulated outside PhysX (projectiles, debris, particles).
+//Bodies are stepped four at a time with SSE2 and split across cores; the scalar tail runs
+//the same operations in the same order, so results do not depend on batch boundaries.
+//Orientations take a first order step q += dt / 2 * (w, 0) * q followed by an exact
+//renormalization, replacing per body normalizeSafe calls.
+class ESGS_EXPORT RigidBodyIntegrator
+{
+public:
+	//v += (gravity + a) dt, v is damped, then p += v dt
+	static void integrateEuler(const RigidBodyStates& states, const IntegratorSettings& settings, float dt, bool parallel = true);
+
+	//Position Verlet: p' = p + (p - prev) damping + (gravity + a) dt^2, prev = p. Derives
+	//velocity when the velocity arrays are set. Use a fixed dt, prev encodes the velocity.
+	static void integrateVerlet(const RigidBodyStates& states, const IntegratorSettings& settings, float dt, bool parallel = true);
+
+	//Orientation only, both integrators call this when the orientation arrays are set
+	static void integrateRotations(const RigidBodyStates& states, float angularDamping, float dt, bool parallel = true);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+//Low-discrepancy sequences in [0, 1). All functions are constexpr and platform
+//independent so sample sets can be rebuilt bit-exactly or baked at compile time.
+namespace sample_sequences
+{
+	constexpr uint32_t primes[16] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53 };
+
+	constexpr float radicalInverse(uint32_t base, uint32_t index)
+	{
+		float inverse = 1.0f / float(base);
+		float factor = inverse;
+		float result = 0.0f;
+		while (index > 0)
+		{
+			result += float(index % base) * factor;
+			index /= base;
+			factor *= inverse;
+		}
+		return result < 1.0f ? result : 0.99999994f;
+	}
+
+	//dimension < 16
+	constexpr float halton(uint32_t index, uint32_t dimension)
+	{
+		return radicalInverse(primes[dimension & 15], index);
+	}
+
+	constexpr uint32_t reverseBits(uint32_t v)
+	{
+		v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+		v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+		v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+		v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+		return (v >> 16) | (v << 16);
+	}
+
+	constexpr float toUnitFloat(uint32_t bits)
+	{
+		return float(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//First two Sobol dimensions, scramble is a random digit (xor) scramble per dimension
+	constexpr float sobol(uint32_t index, uint32_t dimension, uint32_t scramble = 0)
+	{
+		if (dimension == 0)
+			return toUnitFloat(reverseBits(index) ^ scramble);
+
+		uint32_t result = scramble;
+		for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+		{
+			if (index & 1)
+				result ^= v;
+		}
+		return toUnitFloat(result);
+	}
+
+	//Roberts' R2 sequence based on the plastic number
+	constexpr double r2Alpha1 = 0.7548776662466927;
+	constexpr double r2Alpha2 = 0.5698402909980532;
+
+	constexpr float r2(uint32_t index, uint32_t dimension)
+	{
+		double alpha = dimension == 0 ? r2Alpha1 : r2Alpha2;
+		double v = 0.5 + alpha * double(index);
+		float f = float(v - double(int64_t(v)));
+		return f < 1.0f ? f : 0.99999994f;
+	}
+}
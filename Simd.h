@@ -0,0 +1,16 @@
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ESGS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//Per-function instruction set selection for runtime dispatched kernels (BatchKernels),
+//MSVC accepts the intrinsics without it
+#if defined(ESGS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define ESGS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define ESGS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx2,fma")))
+#else
+#define ESGS_TARGET_AVX2
+#define ESGS_TARGET_AVX512
+#endif
@@ -0,0 +1,436 @@
+#include "Spline.h"
+#include "AsyncCore.h"
+#include <cmath>
+
+//Queries per task for the batch entry points
+#define SPLINE_PARALLEL_CHUNK 1024
+
+template<typename T>
+static void run(size_t count, bool parallel, T body)
+{
+    if (parallel)
+        __parallel_for(count, SPLINE_PARALLEL_CHUNK, body);
+    else
+        body((size_t)0, count);
+}
+
+static inline Vector3D combine(float w0, const Vector3D& p0, float w1, const Vector3D& p1,
+    float w2, const Vector3D& p2, float w3, const Vector3D& p3)
+{
+    return Vector3D(
+        w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+        w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y,
+        w0 * p0.z + w1 * p1.z + w2 * p2.z + w3 * p3.z);
+}
+
+static inline Vector3D polynomial(const Vector3D* c, float t)
+{
+    return Vector3D(
+        ((c[3].x * t + c[2].x) * t + c[1].x) * t + c[0].x,
+        ((c[3].y * t + c[2].y) * t + c[1].y) * t + c[0].y,
+        ((c[3].z * t + c[2].z) * t + c[1].z) * t + c[0].z);
+}
+
+static inline Vector3D derivative(const Vector3D* c, float t)
+{
+    return Vector3D(
+        (3.0f * c[3].x * t + 2.0f * c[2].x) * t + c[1].x,
+        (3.0f * c[3].y * t + 2.0f * c[2].y) * t + c[1].y,
+        (3.0f * c[3].z * t + 2.0f * c[2].z) * t + c[1].z);
+}
+
+static inline float speed(const Vector3D* c, float t)
+{
+    Vector3D d = derivative(c, t);
+    return sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+//Wraps u into [0, range) for loops, clamps to [0, range] otherwise
+static inline float wrapParameter(float u, float range, bool looped)
+{
+    if (looped)
+    {
+        u = fmodf(u, range);
+        return u < 0.0f ? u + range : u;
+    }
+    return u < 0.0f ? 0.0f : (u > range ? range : u);
+}
+
+void Spline::setType(SplineType type)
+{
+    m_type = type;
+    rebuild();
+}
+
+void Spline::setLooped(bool looped)
+{
+    m_looped = looped;
+    rebuild();
+}
+
+void Spline::setPoints(const Vector3D* points, size_t count)
+{
+    m_points.assign(points, points + count);
+    rebuild();
+}
+
+void Spline::addPoint(const Vector3D& point)
+{
+    m_points.push_back(point);
+    rebuild();
+}
+
+void Spline::clear()
+{
+    m_points.clear();
+    rebuild();
+}
+
+void Spline::rebuild()
+{
+    m_coefficients.clear();
+    m_arc_params.clear();
+    m_arc_step = 0.0f;
+    m_length = 0.0f;
+
+    size_t n = m_points.size();
+    if (n < 2)
+        return;
+
+    //Control points of segment i, ends of open Catmull-Rom splines use mirrored phantom points
+    auto point = [&](ptrdiff_t i) -> Vector3D
+    {
+        if (m_looped)
+            return m_points[(size_t)((i % (ptrdiff_t)n + (ptrdiff_t)n) % (ptrdiff_t)n)];
+        if (i < 0)
+            return combine(2.0f, m_points[0], -1.0f, m_points[1], 0.0f, m_points[0], 0.0f, m_points[0]);
+        if (i >= (ptrdiff_t)n)
+            return combine(2.0f, m_points[n - 1], -1.0f, m_points[n - 2], 0.0f, m_points[0], 0.0f, m_points[0]);
+        return m_points[(size_t)i];
+    };
+
+    size_t segments = 0;
+    switch (m_type)
+    {
+    case SplineType::CatmullRom:
+        segments = m_looped ? n : n - 1;
+        break;
+    case SplineType::Bezier:
+        segments = m_looped ? n / 3 : (n - 1) / 3;
+        break;
+    case SplineType::BSpline:
+        segments = m_looped ? n : (n >= 4 ? n - 3 : 0);
+        break;
+    }
+
+    m_coefficients.resize(segments * 4);
+    for (size_t s = 0; s < segments; s++)
+    {
+        Vector3D* c = &m_coefficients[s * 4];
+        ptrdiff_t i = (ptrdiff_t)s;
+        switch (m_type)
+        {
+        case SplineType::CatmullRom:
+        {
+            Vector3D p0 = point(i - 1), p1 = point(i), p2 = point(i + 1), p3 = point(i + 2);
+            c[0] = p1;
+            c[1] = combine(-0.5f, p0, 0.0f, p1, 0.5f, p2, 0.0f, p3);
+            c[2] = combine(1.0f, p0, -2.5f, p1, 2.0f, p2, -0.5f, p3);
+            c[3] = combine(-0.5f, p0, 1.5f, p1, -1.5f, p2, 0.5f, p3);
+            break;
+        }
+        case SplineType::Bezier:
+        {
+            Vector3D p0 = point(i * 3), p1 = point(i * 3 + 1), p2 = point(i * 3 + 2), p3 = point(i * 3 + 3);
+            c[0] = p0;
+            c[1] = combine(-3.0f, p0, 3.0f, p1, 0.0f, p2, 0.0f, p3);
+            c[2] = combine(3.0f, p0, -6.0f, p1, 3.0f, p2, 0.0f, p3);
+            c[3] = combine(-1.0f, p0, 3.0f, p1, -3.0f, p2, 1.0f, p3);
+            break;
+        }
+        case SplineType::BSpline:
+        {
+            Vector3D p0 = point(i), p1 = point(i + 1), p2 = point(i + 2), p3 = point(i + 3);
+            c[0] = combine(1.0f / 6.0f, p0, 4.0f / 6.0f, p1, 1.0f / 6.0f, p2, 0.0f, p3);
+            c[1] = combine(-0.5f, p0, 0.0f, p1, 0.5f, p2, 0.0f, p3);
+            c[2] = combine(0.5f, p0, -1.0f, p1, 0.5f, p2, 0.0f, p3);
+            c[3] = combine(-1.0f / 6.0f, p0, 0.5f, p1, -0.5f, p2, 1.0f / 6.0f, p3);
+            break;
+        }
+        }
+    }
+}
+
+const Vector3D* Spline::segment(float u, float& t) const
+{
+    size_t segments = getSegmentCount();
+    u = wrapParameter(u, (float)segments, m_looped);
+    size_t s = (size_t)u;
+    if (s >= segments)
+        s = segments - 1;
+    t = u - (float)s;
+    return &m_coefficients[s * 4];
+}
+
+Vector3D Spline::evaluate(float u) const
+{
+    if (m_coefficients.empty())
+        return m_points.empty() ? Vector3D() : m_points[0];
+
+    float t;
+    const Vector3D* c = segment(u, t);
+    return polynomial(c, t);
+}
+
+Vector3D Spline::evaluateTangent(float u) const
+{
+    if (m_coefficients.empty())
+        return Vector3D();
+
+    float t;
+    const Vector3D* c = segment(u, t);
+    return derivative(c, t);
+}
+
+void Spline::evaluate(const float* u, size_t count, Vector3D* positions, Vector3D* tangents, bool parallel) const
+{
+    run(count, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            positions[i] = evaluate(u[i]);
+            if (tangents)
+                tangents[i] = evaluateTangent(u[i]);
+        }
+    });
+}
+
+//Five point Gauss-Legendre quadrature of the speed
+float Spline::arcLength(uint32_t segment, float t0, float t1) const
+{
+    static const float nodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+    static const float weights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
+    const Vector3D* c = &m_coefficients[segment * 4];
+    float half = 0.5f * (t1 - t0);
+    float mid = 0.5f * (t1 + t0);
+    float sum = 0.0f;
+    for (int i = 0; i < 5; i++)
+        sum += weights[i] * speed(c, mid + half * nodes[i]);
+    return sum * half;
+}
+
+void Spline::buildArcLengthTable(uint32_t samplesPerSegment)
+{
+    m_arc_params.clear();
+    m_arc_step = 0.0f;
+    m_length = 0.0f;
+
+    size_t segments = getSegmentCount();
+    if (segments == 0)
+        return;
+    if (samplesPerSegment == 0)
+        samplesPerSegment = 1;
+
+    //Cumulative length at u = k / samplesPerSegment
+    size_t intervals = segments * samplesPerSegment;
+    float step = 1.0f / (float)samplesPerSegment;
+    std::vector<float> cumulative(intervals + 1);
+    cumulative[0] = 0.0f;
+    for (size_t k = 0; k < intervals; k++)
+    {
+        uint32_t s = (uint32_t)(k / samplesPerSegment);
+        float t0 = (float)(k % samplesPerSegment) * step;
+        cumulative[k + 1] = cumulative[k] + arcLength(s, t0, t0 + step);
+    }
+
+    m_length = cumulative[intervals];
+    m_arc_params.resize(intervals + 1);
+    if (m_length <= 0.0f)
+        return;
+
+    //Invert at evenly spaced distances: bracket in the cumulative table, linear guess,
+    //then one Newton step on the exact length of the partial interval
+    m_arc_step = m_length / (float)intervals;
+    size_t k = 0;
+    for (size_t i = 0; i <= intervals; i++)
+    {
+        float target = (float)i * m_arc_step;
+        while (k + 1 < intervals && cumulative[k + 1] < target)
+            k++;
+
+        uint32_t s = (uint32_t)(k / samplesPerSegment);
+        float t0 = (float)(k % samplesPerSegment) * step;
+        float span = cumulative[k + 1] - cumulative[k];
+        float f = span > 0.0f ? (target - cumulative[k]) / span : 0.0f;
+        f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+        float t = t0 + f * step;
+
+        float v = speed(&m_coefficients[s * 4], t);
+        if (v > 0.0f)
+        {
+            t -= (cumulative[k] + arcLength(s, t0, t) - target) / v;
+            t = t < t0 ? t0 : (t > t0 + step ? t0 + step : t);
+        }
+        m_arc_params[i] = (float)s + t;
+    }
+}
+
+float Spline::parameterAtDistance(float distance) const
+{
+    if (m_arc_params.empty())
+        return 0.0f;
+    if (m_arc_step <= 0.0f)
+        return 0.0f;
+
+    float d = wrapParameter(distance, m_length, m_looped) / m_arc_step;
+    size_t last = m_arc_params.size() - 1;
+    size_t i = (size_t)d;
+    if (i >= last)
+        return m_arc_params[last];
+
+    float f = d - (float)i;
+    return m_arc_params[i] + (m_arc_params[i + 1] - m_arc_params[i]) * f;
+}
+
+Vector3D Spline::sampleAtDistance(float distance) const
+{
+    return evaluate(parameterAtDistance(distance));
+}
+
+void Spline::sampleAtDistance(const float* distances, size_t count, Vector3D* positions, Vector3D* tangents, bool parallel) const
+{
+    run(count, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            float u = parameterAtDistance(distances[i]);
+            positions[i] = evaluate(u);
+            if (tangents)
+                tangents[i] = evaluateTangent(u);
+        }
+    });
+}
+
+//Logarithm of a unit quaternion, w is zero
+static Quaternion quaternionLog(const Quaternion& q)
+{
+    float s = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z);
+    if (s <= epsilon)
+        return Quaternion(q.x, q.y, q.z, 0.0f);
+
+    float scale = atan2f(s, q.w) / s;
+    return Quaternion(q.x * scale, q.y * scale, q.z * scale, 0.0f);
+}
+
+static Quaternion quaternionExp(const Quaternion& q)
+{
+    float a = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z);
+    float scale = a > epsilon ? sinf(a) / a : 1.0f;
+    return Quaternion(q.x * scale, q.y * scale, q.z * scale, cosf(a));
+}
+
+void QuaternionSpline::setLooped(bool looped)
+{
+    m_looped = looped;
+    rebuild();
+}
+
+void QuaternionSpline::setKeys(const Quaternion* keys, size_t count)
+{
+    m_keys.assign(keys, keys + count);
+    for (size_t i = 1; i < m_keys.size(); i++)
+    {
+        if (m_keys[i - 1].dot(m_keys[i]) < 0.0f)
+            m_keys[i] = m_keys[i] * -1.0f;
+    }
+    rebuild();
+}
+
+void QuaternionSpline::addKey(const Quaternion& key)
+{
+    m_keys.push_back(key);
+    size_t n = m_keys.size();
+    if (n > 1 && m_keys[n - 2].dot(m_keys[n - 1]) < 0.0f)
+        m_keys[n - 1] = m_keys[n - 1] * -1.0f;
+    rebuild();
+}
+
+void QuaternionSpline::clear()
+{
+    m_keys.clear();
+    m_controls.clear();
+}
+
+size_t QuaternionSpline::getSegmentCount() const
+{
+    size_t n = m_keys.size();
+    if (n < 2)
+        return 0;
+    return m_looped ? n : n - 1;
+}
+
+//s_i = q_i exp(-(log(q_i^-1 q_i+1) + log(q_i^-1 q_i-1)) / 4), open ends use the key itself
+void QuaternionSpline::rebuild()
+{
+    size_t n = m_keys.size();
+    m_controls = m_keys;
+    if (n < 3 && !(m_looped && n == 2))
+        return;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!m_looped && (i == 0 || i == n - 1))
+            continue;
+
+        Quaternion q = m_keys[i];
+        Quaternion prev = m_keys[(i + n - 1) % n];
+        Quaternion next = m_keys[(i + 1) % n];
+        if (q.dot(prev) < 0.0f)
+            prev = prev * -1.0f;
+        if (q.dot(next) < 0.0f)
+            next = next * -1.0f;
+
+        Quaternion inverse = q.getConjugate();
+        Quaternion a = quaternionLog(inverse * next);
+        Quaternion b = quaternionLog(inverse * prev);
+        Quaternion sum((a.x + b.x) * -0.25f, (a.y + b.y) * -0.25f, (a.z + b.z) * -0.25f, 0.0f);
+        m_controls[i] = q * quaternionExp(sum);
+    }
+}
+
+Quaternion QuaternionSpline::evaluate(float u) const
+{
+    size_t segments = getSegmentCount();
+    if (segments == 0)
+        return m_keys.empty() ? Quaternion::identity() : m_keys[0];
+
+    u = wrapParameter(u, (float)segments, m_looped);
+    size_t i = (size_t)u;
+    if (i >= segments)
+        i = segments - 1;
+    float t = u - (float)i;
+    size_t j = (i + 1) % m_keys.size();
+
+    Quaternion q0 = m_keys[i], q1 = m_keys[j];
+    Quaternion s0 = m_controls[i], s1 = m_controls[j];
+    //Closing segment of a loop may cross hemispheres
+    if (q0.dot(q1) < 0.0f)
+    {
+        q1 = q1 * -1.0f;
+        s1 = s1 * -1.0f;
+    }
+
+    Quaternion outer = q0.slerp(q1, t);
+    Quaternion inner = s0.slerp(s1, t);
+    return outer.slerp(inner, 2.0f * t * (1.0f - t));
+}
+
+void QuaternionSpline::evaluate(const float* u, size_t count, Quaternion* rotations, bool parallel) const
+{
+    run(count, parallel, [=](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            rotations[i] = evaluate(u[i]);
+    });
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3D.h"
+#include "Quaternion.h"
+#include "Export.h"
+
+enum class SplineType : uint8_t
+{
+	//Passes through every point, one segment per pair of neighbouring points
+	CatmullRom,
+	//Point, control, control, point, control, control, point...
+	Bezier,
+	//Uniform cubic B-spline, C2 smooth but does not pass through the points
+	BSpline
+};
+
+//Cubic spline over Vector3D. Parameter u runs from 0 to getSegmentCount(), the integer
+//part selects the segment. Segments are stored as polynomial coefficients, so every type
+//evaluates at the same cost. buildArcLengthTable() adds a distance to parameter table
+//for constant speed sampling in O(1) per query.
+class ESGS_EXPORT Spline
+{
+public:
+	Spline()
+	{
+	}
+
+	Spline(SplineType type) : m_type(type)
+	{
+	}
+
+	void setType(SplineType type);
+	void setLooped(bool looped);
+	void setPoints(const Vector3D* points, size_t count);
+	void addPoint(const Vector3D& point);
+	void clear();
+
+	SplineType getType() const { return m_type; }
+	bool isLooped() const { return m_looped; }
+	size_t getPointCount() const { return m_points.size(); }
+	size_t getSegmentCount() const { return m_coefficients.size() / 4; }
+
+	Vector3D evaluate(float u) const;
+	//Derivative with respect to u, not normalized
+	Vector3D evaluateTangent(float u) const;
+
+	void evaluate(const float* u, size_t count, Vector3D* positions, Vector3D* tangents = nullptr, bool parallel = true) const;
+
+	//Table entries per segment, the table is dropped whenever the points change
+	void buildArcLengthTable(uint32_t samplesPerSegment = 16);
+	bool hasArcLengthTable() const { return !m_arc_params.empty(); }
+	//Zero until buildArcLengthTable() was called
+	float getLength() const { return m_length; }
+
+	//Distances are clamped to [0, getLength()], or wrapped when looped
+	float parameterAtDistance(float distance) const;
+	Vector3D sampleAtDistance(float distance) const;
+
+	void sampleAtDistance(const float* distances, size_t count, Vector3D* positions, Vector3D* tangents = nullptr, bool parallel = true) const;
+
+private:
+	void rebuild();
+	float arcLength(uint32_t segment, float t0, float t1) const;
+	const Vector3D* segment(float u, float& t) const;
+
+private:
+	SplineType m_type = SplineType::CatmullRom;
+	bool m_looped = false;
+
+	std::vector<Vector3D> m_points;
+	//a, b, c, d per segment: p(t) = a + b t + c t^2 + d t^3
+	std::vector<Vector3D> m_coefficients;
+
+	//Parameter at evenly spaced distances, m_arc_params[i] is at i * m_arc_step
+	std::vector<float> m_arc_params;
+	float m_arc_step = 0.0f;
+	float m_length = 0.0f;
+};
+
+//Squad interpolation through rotation keys, C1 continuous unlike chained slerps.
+//Keys are flipped on insertion so that neighbours always take the shortest arc.
+//Parameter u runs from 0 to getSegmentCount() like Spline.
+class ESGS_EXPORT QuaternionSpline
+{
+public:
+	QuaternionSpline()
+	{
+	}
+
+	void setLooped(bool looped);
+	void setKeys(const Quaternion* keys, size_t count);
+	void addKey(const Quaternion& key);
+	void clear();
+
+	bool isLooped() const { return m_looped; }
+	size_t getKeyCount() const { return m_keys.size(); }
+	size_t getSegmentCount() const;
+
+	Quaternion evaluate(float u) const;
+	void evaluate(const float* u, size_t count, Quaternion* rotations, bool parallel = true) const;
+
+private:
+	void rebuild();
+
+private:
+	bool m_looped = false;
+
+	std::vector<Quaternion> m_keys;
+	//Inner control point of each key
+	std::vector<Quaternion> m_controls;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+//Code between ESGS_STRICT_FLOAT_BEGIN and ESGS_STRICT_FLOAT_END keeps every a * b + c
+//as two rounded operations. Compilers otherwise fuse them into FMA when the target has
+//it (GCC does so by default, even across statements), which changes results between
+//builds and between scalar and SIMD paths. Wrap code whose output is promised to be
+//bit-identical across platforms or code paths.
+#if defined(__clang__)
+#define ESGS_STRICT_FLOAT_BEGIN _Pragma("float_control(push)") _Pragma("clang fp contract(off)")
+#define ESGS_STRICT_FLOAT_END _Pragma("float_control(pop)")
+#elif defined(__GNUC__)
+#define ESGS_STRICT_FLOAT_BEGIN _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define ESGS_STRICT_FLOAT_END _Pragma("GCC pop_options")
+#elif defined(_MSC_VER)
+#define ESGS_STRICT_FLOAT_BEGIN __pragma(float_control(precise, on, push)) __pragma(fp_contract(off))
+#define ESGS_STRICT_FLOAT_END __pragma(float_control(pop))
+#else
+#define ESGS_STRICT_FLOAT_BEGIN
+#define ESGS_STRICT_FLOAT_END
+#endif
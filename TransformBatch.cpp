@@ -0,0 +1,220 @@
+#include "TransformBatch.h"
+#include "Simd.h"
+#include "StrictFloat.h"
+
+//The SSE paths and the scalar tails must give the same results in every build, so
+//nothing in here is contracted
+ESGS_STRICT_FLOAT_BEGIN
+
+#ifdef ESGS_SSE2
+static __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static __m128 absolute(__m128 v)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+//Four matrices per iteration, transposed to one register per matrix element
+static size_t decompose4(const Matrix4x4* m, Vector3D* t, Quaternion* r, Vector3D* s, uint8_t* shear)
+{
+    __m128 e[3][3];
+    for (int row = 0; row < 3; row++)
+    {
+        __m128 a = _mm_loadu_ps(m[0].m_mat[row]);
+        __m128 b = _mm_loadu_ps(m[1].m_mat[row]);
+        __m128 c = _mm_loadu_ps(m[2].m_mat[row]);
+        __m128 d = _mm_loadu_ps(m[3].m_mat[row]);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        e[row][0] = a;
+        e[row][1] = b;
+        e[row][2] = c;
+    }
+
+    for (int k = 0; k < 4; k++)
+        t[k] = Vector3D(m[k].m_mat[3][0], m[k].m_mat[3][1], m[k].m_mat[3][2]);
+
+    __m128 sc[3];
+    for (int row = 0; row < 3; row++)
+    {
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[row][0], e[row][0]), _mm_mul_ps(e[row][1], e[row][1])),
+            _mm_mul_ps(e[row][2], e[row][2]));
+        sc[row] = _mm_sqrt_ps(len2);
+    }
+
+    __m128 det = _mm_sub_ps(
+        _mm_add_ps(
+            _mm_mul_ps(e[0][0], _mm_sub_ps(_mm_mul_ps(e[1][1], e[2][2]), _mm_mul_ps(e[1][2], e[2][1]))),
+            _mm_mul_ps(e[0][2], _mm_sub_ps(_mm_mul_ps(e[1][0], e[2][1]), _mm_mul_ps(e[1][1], e[2][0])))),
+        _mm_mul_ps(e[0][1], _mm_sub_ps(_mm_mul_ps(e[1][0], e[2][2]), _mm_mul_ps(e[1][2], e[2][0]))));
+    __m128 negative = _mm_cmplt_ps(det, _mm_setzero_ps());
+    sc[0] = _mm_xor_ps(sc[0], _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+
+    __m128 eps = _mm_set1_ps((float)epsilon);
+    __m128 one = _mm_set1_ps(1.0f);
+    for (int row = 0; row < 3; row++)
+    {
+        __m128 valid = _mm_cmpgt_ps(absolute(sc[row]), eps);
+        __m128 inv = _mm_and_ps(valid, _mm_div_ps(one, sc[row]));
+        e[row][0] = _mm_mul_ps(e[row][0], inv);
+        e[row][1] = _mm_mul_ps(e[row][1], inv);
+        e[row][2] = _mm_mul_ps(e[row][2], inv);
+    }
+
+    //All four branches of rotationFromAxes, blended by the largest diagonal term
+    __m128 quarter = _mm_set1_ps(0.25f);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 m00 = e[0][0], m11 = e[1][1], m22 = e[2][2];
+    __m128 d12 = _mm_sub_ps(e[1][2], e[2][1]), s12 = _mm_add_ps(e[1][2], e[2][1]);
+    __m128 d20 = _mm_sub_ps(e[2][0], e[0][2]), s20 = _mm_add_ps(e[2][0], e[0][2]);
+    __m128 d01 = _mm_sub_ps(e[0][1], e[1][0]), s01 = _mm_add_ps(e[0][1], e[1][0]);
+
+    __m128 trace = _mm_add_ps(_mm_add_ps(m00, m11), m22);
+    __m128 tw = _mm_add_ps(trace, one);
+    __m128 tx = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(one, m00), m11), m22);
+    __m128 ty = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(one, m11), m00), m22);
+    __m128 tz = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(one, m22), m00), m11);
+
+    __m128 useW = _mm_cmpgt_ps(trace, _mm_setzero_ps());
+    __m128 useX = _mm_andnot_ps(useW, _mm_and_ps(_mm_cmpgt_ps(m00, m11), _mm_cmpgt_ps(m00, m22)));
+    __m128 useY = _mm_andnot_ps(_mm_or_ps(useW, useX), _mm_cmpgt_ps(m11, m22));
+    __m128 useZ = _mm_andnot_ps(_mm_or_ps(_mm_or_ps(useW, useX), useY), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+    __m128 big = select(useW, tw, select(useX, tx, select(useY, ty, tz)));
+    //Constant first: _mm_max_ps returns its second operand for NaN, which keeps NaN like the scalar path
+    big = _mm_max_ps(_mm_set1_ps(1e-20f), big);
+    __m128 sq = _mm_mul_ps(_mm_sqrt_ps(big), two);
+    __m128 inv = _mm_div_ps(one, sq);
+    __m128 largest = _mm_mul_ps(quarter, sq);
+
+    __m128 qw = select(useW, largest, _mm_mul_ps(select(useX, d12, select(useY, d20, d01)), inv));
+    __m128 qx = select(useX, largest, _mm_mul_ps(select(useW, d12, select(useY, s01, s20)), inv));
+    __m128 qy = select(useY, largest, _mm_mul_ps(select(useW, d20, select(useX, s01, s12)), inv));
+    __m128 qz = select(useZ, largest, _mm_mul_ps(select(useW, d01, select(useX, s20, s12)), inv));
+
+    __m128 dot01 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0][0], e[1][0]), _mm_mul_ps(e[0][1], e[1][1])), _mm_mul_ps(e[0][2], e[1][2]));
+    __m128 dot02 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0][0], e[2][0]), _mm_mul_ps(e[0][1], e[2][1])), _mm_mul_ps(e[0][2], e[2][2]));
+    __m128 dot12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[1][0], e[2][0]), _mm_mul_ps(e[1][1], e[2][1])), _mm_mul_ps(e[1][2], e[2][2]));
+    __m128 tol = _mm_set1_ps(TRS_SHEAR_TOLERANCE);
+    __m128 sheared = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(absolute(dot01), tol), _mm_cmpgt_ps(absolute(dot02), tol)), _mm_cmpgt_ps(absolute(dot12), tol));
+    int mask = _mm_movemask_ps(sheared);
+
+    alignas(16) float out[7][4];
+    _mm_store_ps(out[0], qx);
+    _mm_store_ps(out[1], qy);
+    _mm_store_ps(out[2], qz);
+    _mm_store_ps(out[3], qw);
+    _mm_store_ps(out[4], sc[0]);
+    _mm_store_ps(out[5], sc[1]);
+    _mm_store_ps(out[6], sc[2]);
+
+    size_t count = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        r[k] = Quaternion(out[0][k], out[1][k], out[2][k], out[3][k]);
+        s[k] = Vector3D(out[4][k], out[5][k], out[6][k]);
+        int flag = (mask >> k) & 1;
+        if (shear)
+            shear[k] = (uint8_t)flag;
+        count += flag;
+    }
+
+    return count;
+}
+
+static void compose4(const Vector3D* t, const Quaternion* r, const Vector3D* s, Matrix4x4* m)
+{
+    __m128 x = _mm_loadu_ps(&r[0].x);
+    __m128 y = _mm_loadu_ps(&r[1].x);
+    __m128 z = _mm_loadu_ps(&r[2].x);
+    __m128 w = _mm_loadu_ps(&r[3].x);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    __m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+    __m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+    __m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+    __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+    __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+    __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+    __m128 zero = _mm_setzero_ps();
+
+    __m128 rows[3][4] =
+    {
+        {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+            _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+            _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+            zero
+        },
+        {
+            _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+            _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+            zero
+        },
+        {
+            _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+            _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+            zero
+        }
+    };
+
+    for (int row = 0; row < 3; row++)
+    {
+        __m128 a = rows[row][0], b = rows[row][1], c = rows[row][2], d = rows[row][3];
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(m[0].m_mat[row], a);
+        _mm_storeu_ps(m[1].m_mat[row], b);
+        _mm_storeu_ps(m[2].m_mat[row], c);
+        _mm_storeu_ps(m[3].m_mat[row], d);
+    }
+
+    for (int k = 0; k < 4; k++)
+        _mm_storeu_ps(m[k].m_mat[3], _mm_setr_ps(t[k].x, t[k].y, t[k].z, 1.0f));
+}
+#endif
+
+size_t TransformBatch::decompose(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+    Quaternion* rotations, Vector3D* scales, uint8_t* shear)
+{
+    size_t sheared = 0;
+    size_t i = 0;
+
+#ifdef ESGS_SSE2
+    for (; i + 4 <= count; i += 4)
+        sheared += decompose4(matrices + i, translations + i, rotations + i, scales + i, shear ? shear + i : nullptr);
+#endif
+
+    for (; i < count; i++)
+    {
+        bool s = decompose(matrices[i], translations[i], rotations[i], scales[i]);
+        if (shear)
+            shear[i] = s ? 1 : 0;
+        sheared += s ? 1 : 0;
+    }
+
+    return sheared;
+}
+
+void TransformBatch::compose(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+    size_t count, Matrix4x4* matrices)
+{
+    size_t i = 0;
+
+#ifdef ESGS_SSE2
+    for (; i + 4 <= count; i += 4)
+        compose4(translations + i, rotations + i, scales + i, matrices + i);
+#endif
+
+    for (; i < count; i++)
+        compose(translations[i], rotations[i], scales[i], matrices[i]);
+}
+
+ESGS_STRICT_FLOAT_END
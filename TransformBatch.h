@@ -0,0 +1,134 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "Vector3D.h"
+#include "Quaternion.h"
+#include "Matrix4x4.h"
+#include "Export.h"
+
+#ifndef TRS_SHEAR_TOLERANCE
+#define TRS_SHEAR_TOLERANCE 0.0001f
+#endif // !TRS_SHEAR_TOLERANCE
+
+//Translation/rotation/scale conversion for row-vector matrices (rows 0..2 are the
+//scaled basis axes, row 3 the translation), matching Matrix4x4::setTranslation.
+class ESGS_EXPORT TransformBatch
+{
+public:
+	//Returns true when the basis axes are not orthogonal, in which case the
+	//rotation is the closest one found from the normalized axes.
+	static bool decompose(const Matrix4x4& matrix, Vector3D& translation, Quaternion& rotation, Vector3D& scale)
+	{
+		const float (*m)[4] = matrix.m_mat;
+
+		translation = Vector3D(m[3][0], m[3][1], m[3][2]);
+
+		float sx = sqrtf(m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2]);
+		float sy = sqrtf(m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2]);
+		float sz = sqrtf(m[2][0] * m[2][0] + m[2][1] * m[2][1] + m[2][2] * m[2][2]);
+
+		float det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+			m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+			m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+		if (det < 0.0f)
+			sx = -sx;
+
+		scale = Vector3D(sx, sy, sz);
+
+		float ix = fabsf(sx) > epsilon ? 1.0f / sx : 0.0f;
+		float iy = sy > epsilon ? 1.0f / sy : 0.0f;
+		float iz = sz > epsilon ? 1.0f / sz : 0.0f;
+
+		float r[3][3] =
+		{
+			{ m[0][0] * ix, m[0][1] * ix, m[0][2] * ix },
+			{ m[1][0] * iy, m[1][1] * iy, m[1][2] * iy },
+			{ m[2][0] * iz, m[2][1] * iz, m[2][2] * iz }
+		};
+
+		rotation = rotationFromAxes(r);
+
+		float d01 = r[0][0] * r[1][0] + r[0][1] * r[1][1] + r[0][2] * r[1][2];
+		float d02 = r[0][0] * r[2][0] + r[0][1] * r[2][1] + r[0][2] * r[2][2];
+		float d12 = r[1][0] * r[2][0] + r[1][1] * r[2][1] + r[1][2] * r[2][2];
+		return fabsf(d01) > TRS_SHEAR_TOLERANCE || fabsf(d02) > TRS_SHEAR_TOLERANCE || fabsf(d12) > TRS_SHEAR_TOLERANCE;
+	}
+
+	static void compose(const Vector3D& translation, const Quaternion& rotation, const Vector3D& scale, Matrix4x4& matrix)
+	{
+		float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+		float xx = x * x, yy = y * y, zz = z * z;
+		float xy = x * y, xz = x * z, yz = y * z;
+		float wx = w * x, wy = w * y, wz = w * z;
+
+		float (*m)[4] = matrix.m_mat;
+		m[0][0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+		m[0][1] = 2.0f * (xy + wz) * scale.x;
+		m[0][2] = 2.0f * (xz - wy) * scale.x;
+		m[0][3] = 0.0f;
+		m[1][0] = 2.0f * (xy - wz) * scale.y;
+		m[1][1] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+		m[1][2] = 2.0f * (yz + wx) * scale.y;
+		m[1][3] = 0.0f;
+		m[2][0] = 2.0f * (xz + wy) * scale.z;
+		m[2][1] = 2.0f * (yz - wx) * scale.z;
+		m[2][2] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+		m[2][3] = 0.0f;
+		m[3][0] = translation.x;
+		m[3][1] = translation.y;
+		m[3][2] = translation.z;
+		m[3][3] = 1.0f;
+	}
+
+	//Decomposes count matrices. shear may be null, otherwise receives 1 for every
+	//sheared matrix. Returns the number of sheared matrices.
+	static size_t decompose(const Matrix4x4* matrices, size_t count, Vector3D* translations,
+		Quaternion* rotations, Vector3D* scales, uint8_t* shear = nullptr);
+
+	static void compose(const Vector3D* translations, const Quaternion* rotations, const Vector3D* scales,
+		size_t count, Matrix4x4* matrices);
+
+private:
+	//r holds normalized basis axes as rows
+	static Quaternion rotationFromAxes(const float r[3][3])
+	{
+		Quaternion q;
+		float trace = r[0][0] + r[1][1] + r[2][2];
+
+		if (trace > 0.0f)
+		{
+			float s = sqrtf(trace + 1.0f) * 2.0f;
+			q.w = 0.25f * s;
+			q.x = (r[1][2] - r[2][1]) / s;
+			q.y = (r[2][0] - r[0][2]) / s;
+			q.z = (r[0][1] - r[1][0]) / s;
+		}
+		else if (r[0][0] > r[1][1] && r[0][0] > r[2][2])
+		{
+			float s = sqrtf(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+			q.w = (r[1][2] - r[2][1]) / s;
+			q.x = 0.25f * s;
+			q.y = (r[1][0] + r[0][1]) / s;
+			q.z = (r[2][0] + r[0][2]) / s;
+		}
+		else if (r[1][1] > r[2][2])
+		{
+			float s = sqrtf(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+			q.w = (r[2][0] - r[0][2]) / s;
+			q.x = (r[1][0] + r[0][1]) / s;
+			q.y = 0.25f * s;
+			q.z = (r[2][1] + r[1][2]) / s;
+		}
+		else
+		{
+			float s = sqrtf(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+			q.w = (r[0][1] - r[1][0]) / s;
+			q.x = (r[2][0] + r[0][2]) / s;
+			q.y = (r[2][1] + r[1][2]) / s;
+			q.z = 0.25f * s;
+		}
+
+		return q;
+	}
+};
@@ -1,7 +1,6 @@
 #pragma once
-#include <PxPhysics.h>
-#include <PxPhysicsAPI.h>
-#include "DLL.h"
+#include "LayoutTraits.h"
+#include "Export.h"
 
 class ESGS_EXPORT Vector2D
 {
@@ -14,11 +13,9 @@ public:
 	{
 	}
 
-	Vector2D(const Vector2D& vector) : x(vector.x), y(vector.y)
-	{
-	}
-
-	Vector2D(const physx::PxVec2& vector) : x(vector.x), y(vector.y)
+	//PxVec2, XMFLOAT2 and other xy types
+	template<typename V, typename std::enable_if<layout_traits::is_xy<V, Vector2D>::value, int>::type = 0>
+	Vector2D(const V& vector) : x((float)vector.x), y((float)vector.y)
 	{
 	}
 
@@ -42,11 +39,6 @@ public:
 		return Vector2D(x * vec.x, y * vec.y);
 	}
 
-	Vector2D operator +(const physx::PxVec2& vec)
-	{
-		return Vector2D(x + vec.x, y + vec.y);
-	}
-
 	bool operator !=(const Vector2D& vec)
 	{
 		return (x != vec.x) && (y != vec.y);
@@ -57,11 +49,9 @@ public:
 		return (x == vec.x) && (y == vec.y);
 	}
 
-	~Vector2D()
-	{
-	}
-
 public:
 	float x = 0;
 	float y = 0;
-};
\ No newline at end of file
+};
+
+ESGS_CHECK_LAYOUT(Vector2D, sizeof(float) * 2);
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <cmath>
+#include "Vector3D.h"
+#include "ProfileCounters.h"
+#include "LayoutTraits.h"
+#include "Simd.h"
+#include "Export.h"
+
+//Vector3D padded to 16 bytes and 16-byte aligned so arrays of it load straight into
+//SSE registers. w is padding and stays 0.
+class ESGS_EXPORT Vector3A
+{
+public:
+	Vector3A() : x(0), y(0), z(0), w(0)
+	{
+	}
+
+	Vector3A(float x, float y, float z) : x(x), y(y), z(z), w(0)
+	{
+	}
+
+	Vector3A(const Vector3D& vector) : x(vector.x), y(vector.y), z(vector.z), w(0)
+	{
+	}
+
+	Vector3D toVector3D() const
+	{
+		return Vector3D(x, y, z);
+	}
+
+	float dot(const Vector3A& vector) const
+	{
+		return x * vector.x + y * vector.y + z * vector.z;
+	}
+
+	Vector3A cross(const Vector3A& vector) const
+	{
+		return Vector3A(y * vector.z - z * vector.y, z * vector.x - x * vector.z, x * vector.y - y * vector.x);
+	}
+
+	float magnitude() const
+	{
+		return sqrtf(dot(*this));
+	}
+
+	//Same zero fallback as Vector3D::normalize
+	void normalize()
+	{
+		ESGS_COUNT(VectorNormalize, 1);
+		float mag = magnitude();
+		if (mag > epsilon)
+		{
+			x /= mag;
+			y /= mag;
+			z /= mag;
+		}
+		else
+		{
+			x = 0;
+			y = 0;
+			z = 0;
+		}
+	}
+
+	Vector3A operator +(const Vector3A& vec) const
+	{
+		return Vector3A(x + vec.x, y + vec.y, z + vec.z);
+	}
+
+	Vector3A operator -(const Vector3A& vec) const
+	{
+		return Vector3A(x - vec.x, y - vec.y, z - vec.z);
+	}
+
+	Vector3A operator *(float num) const
+	{
+		return Vector3A(x * num, y * num, z * num);
+	}
+
+	bool operator ==(const Vector3A& vec) const
+	{
+		return (x == vec.x) && (y == vec.y) && (z == vec.z);
+	}
+
+#ifdef ESGS_SSE2
+	__m128 load() const
+	{
+		return _mm_load_ps(&x);
+	}
+
+	void store(__m128 v)
+	{
+		_mm_store_ps(&x, v);
+		w = 0;
+	}
+#endif
+
+public:
+	alignas(16) float x = 0;
+	float y = 0;
+	float z = 0;
+	float w = 0;
+};
+
+ESGS_CHECK_LAYOUT(Vector3A, sizeof(float) * 4);
+static_assert(alignof(Vector3A) == 16, "Vector3A must be 16-byte aligned");
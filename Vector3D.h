@@ -1,10 +1,9 @@
 #pragma once
-#include <PxPhysics.h>
-#include <PxPhysicsAPI.h>
 #include <cmath>
 #include "Math.h"
-#include "Prerequisites.h"
-#include "DLL.h"
+#include "LayoutTraits.h"
+#include "ProfileCounters.h"
+#include "Export.h"
 
 class ESGS_EXPORT Vector3D
 {
@@ -17,15 +16,9 @@ public:
 	{
 	}
 
-	Vector3D(const Vector3D& vector) : x(vector.x), y(vector.y), z(vector.z)
-	{
-	}
-
-	Vector3D(const physx::PxVec3& vector) : x(vector.x), y(vector.y), z(vector.z)
-	{
-	}
-
-	Vector3D(const physx::PxExtendedVec3& vector) : x(vector.x), y(vector.y), z(vector.z)
+	//PxVec3, PxExtendedVec3, XMFLOAT3 and other xyz types
+	template<typename V, typename std::enable_if<layout_traits::is_xyz<V, Vector3D>::value, int>::type = 0>
+	Vector3D(const V& vector) : x((float)vector.x), y((float)vector.y), z((float)vector.z)
 	{
 	}
 
@@ -100,6 +93,7 @@ public:
 
 	void normalize()
 	{
+		ESGS_COUNT(VectorNormalize, 1);
 		float mag = magnitude();
 		if (mag > epsilon)
 		{
@@ -117,6 +111,7 @@ public:
 
 	static Vector3D normalize(Vector3D value)
 	{
+		ESGS_COUNT(VectorNormalize, 1);
 		float mag = value.magnitude();
 		if (mag > epsilon)
 		{
@@ -223,16 +218,6 @@ public:
 		return Vector3D(x / vec.x, y / vec.y, z / vec.z);
 	}
 
-	Vector3D operator +(const physx::PxVec3& vec)
-	{
-		return Vector3D(x + vec.x, y + vec.y, z + vec.z);
-	}
-
-	Vector3D operator -(const physx::PxVec3& vec)
-	{
-		return Vector3D(x - vec.x, y - vec.y, z - vec.z);
-	}
-
 	bool operator !=(const Vector3D& vec)
 	{
 		return (x != vec.x) && (y != vec.y) && (z != vec.z);
@@ -243,12 +228,11 @@ public:
 		return (x == vec.x) && (y == vec.y) && (z == vec.z);
 	}
 
-	~Vector3D()
-	{
-	}
-
 public:
 	float x = 0;
 	float y = 0;
 	float z = 0;
 };
+
+
+ESGS_CHECK_LAYOUT(Vector3D, sizeof(float) * 3);
\ No newline at end of file
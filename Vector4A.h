@@ -0,0 +1,38 @@
+#pragma once
+#include "Vector4D.h"
+#include "LayoutTraits.h"
+#include "Simd.h"
+#include "Export.h"
+
+//16-byte aligned Vector4D for arrays that are loaded with aligned SSE loads.
+//Vector4D itself keeps 4-byte alignment so it can still view PxVec4 arrays.
+class ESGS_EXPORT alignas(16) Vector4A : public Vector4D
+{
+public:
+	Vector4A()
+	{
+	}
+
+	Vector4A(float x, float y, float z, float w) : Vector4D(x, y, z, w)
+	{
+	}
+
+	Vector4A(const Vector4D& vector) : Vector4D(vector)
+	{
+	}
+
+#ifdef ESGS_SSE2
+	__m128 load() const
+	{
+		return _mm_load_ps(&x);
+	}
+
+	void store(__m128 v)
+	{
+		_mm_store_ps(&x, v);
+	}
+#endif
+};
+
+ESGS_CHECK_LAYOUT(Vector4A, sizeof(float) * 4);
+static_assert(alignof(Vector4A) == 16, "Vector4A must be 16-byte aligned");
@@ -1,9 +1,7 @@
 #pragma once
 #include "Vector3D.h"
-#include <PxPhysics.h>
-#include <PxPhysicsAPI.h>
-#include "Prerequisites.h"
-#include "DLL.h"
+#include "LayoutTraits.h"
+#include "Export.h"
 
 class ESGS_EXPORT Vector4D
 {
@@ -16,11 +14,9 @@ public:
 	{
 	}
 
-	Vector4D(const Vector4D& vector) : x(vector.x), y(vector.y), z(vector.z), w(vector.w)
-	{
-	}
-
-	Vector4D(const physx::PxVec4& vector) : x(vector.x), y(vector.y), z(vector.z), w(vector.w)
+	//PxVec4, XMFLOAT4 and other xyzw types
+	template<typename V, typename std::enable_if<layout_traits::is_xyzw<V, Vector4D>::value, int>::type = 0>
+	Vector4D(const V& vector) : x((float)vector.x), y((float)vector.y), z((float)vector.z), w((float)vector.w)
 	{
 	}
 
@@ -28,7 +24,9 @@ public:
 	{
 	}
 
-	Vector4D(const physx::PxVec3& vector) : x(vector.x), y(vector.y), z(vector.z), w(1.0)
+	//PxVec3, XMFLOAT3 and other xyz types
+	template<typename V, typename std::enable_if<layout_traits::is_xyz<V, Vector3D>::value, int>::type = 0>
+	Vector4D(const V& vector) : x((float)vector.x), y((float)vector.y), z((float)vector.z), w(1.0)
 	{
 	}
 
@@ -49,14 +47,12 @@ public:
 	{
 		return (x == vec.x) && (y == vec.y) && (z == vec.z) && (w == vec.w);
 	}
-	
-	~Vector4D()
-	{
-	}
 
 public:
 	float x = 0;
 	float y = 0;
 	float z = 0;
 	float w = 0;
-};
\ No newline at end of file
+};
+
+ESGS_CHECK_LAYOUT(Vector4D, sizeof(float) * 4);
\ No newline at end of file